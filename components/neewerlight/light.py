@@ -1,59 +1,311 @@
+import json
+import math
+from pathlib import Path
+import re
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
+import esphome.final_validate as fv
+from esphome import automation
 from esphome.components import ble_client, light
 from esphome.components.rgbct import light as rgbct_light
 from esphome.components.neewerlight import output as nw_output
 from esphome.components.light import effects as light_effects
 from esphome.components.light.types import LightEffect
 from esphome.const import (
+    CONF_BLUE,
+    CONF_BRIGHTNESS,
     CONF_COLOR_INTERLOCK,
+    CONF_COLOR_TEMPERATURE,
+    CONF_DURATION,
     CONF_EFFECTS,
     CONF_GAMMA_CORRECT,
+    CONF_GREEN,
+    CONF_LIGHT,
     CONF_NAME,
     CONF_OUTPUT_ID,
+    CONF_PLATFORM,
+    CONF_RED,
 )
+from esphome.core import CORE
+from esphome.helpers import cpp_string_escape
 
 CONF_GREEN_MAGENTA_BIAS = "green_magenta_bias"
+CONF_REQUIRE_RESPONSE = "require_response"
+CONF_MAX_FRAME_RATE = "max_frame_rate"
+CONF_PACKET_TRACE = "packet_trace"
+CONF_STATS_INTERVAL = "stats_interval"
+CONF_STATUS_VERIFY_DELAY = "status_verify_delay"
+CONF_TRACK_CHANNEL = "track_channel"
+CONF_STATUS_POLL_INTERVAL = "status_poll_interval"
+CONF_CONNECTION = "connection"
+CONF_ACTIVE = "active"
+CONF_IDLE = "idle"
+CONF_IDLE_AFTER = "idle_after"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_MAX_INTERVAL = "max_interval"
+CONF_LATENCY = "latency"
+CONF_TIMEOUT = "timeout"
+CONF_MTU = "mtu"
+CONF_KEYFRAMES = "keyframes"
+CONF_EASING = "easing"
+CONF_LOOP = "loop"
+CONF_FRAME_RATE = "frame_rate"
+CONF_MAX_FRAMES = "max_frames"
 
 CONF_MODEL = "model"
-MODEL_RGB62 = "rgb62"
-
-RGB62_MIN_KELVIN = 2500.0
-RGB62_MAX_KELVIN = 8500.0
-RGB62_COLD_WHITE_MIRED = 1_000_000.0 / RGB62_MAX_KELVIN
-RGB62_WARM_WHITE_MIRED = 1_000_000.0 / RGB62_MIN_KELVIN
 
 neewerlight_ns = cg.esphome_ns.namespace("neewerlight")
 
+# Light models live in models.json. Each model a configuration uses becomes a
+# traits struct in the generated code (see neewer_model.h for its members), so
+# models nobody uses cost no flash and adding one is a data change.
+MODEL_DB = json.loads((Path(__file__).parent / "models.json").read_text(encoding="utf-8"))
+MODELS = MODEL_DB["models"]
+SCENE_SETS = MODEL_DB["scene_sets"]
+
+FRAME_CLASSIC = "classic"
+FRAME_ADDRESSED = "addressed"
+CCT_MIRED_24 = "mired_24"
+CCT_KELVIN_100 = "kelvin_100"
+# Must match neewer_protocol.h / neewer_light_output.h.
+MSG_MAX_SIZE = 20
+SCENE_MAX_PARAM_BYTES = 8
+SCENE_BYTES = ("brr", "brr2", "cct", "gm", "speed", "sparks", "hue_lsb", "hue_msb", "sat", "color")
+
 NeewerSceneLightEffect = neewerlight_ns.class_("NeewerSceneLightEffect", LightEffect)
+NeewerKeyframeLightEffect = neewerlight_ns.class_("NeewerKeyframeLightEffect", LightEffect)
+NeewerEasing = neewerlight_ns.enum("NeewerEasing", is_class=True)
+EASINGS = {
+    "linear": NeewerEasing.LINEAR,
+    "ease_in": NeewerEasing.EASE_IN,
+    "ease_out": NeewerEasing.EASE_OUT,
+    "ease_in_out": NeewerEasing.EASE_IN_OUT,
+    "step": NeewerEasing.STEP,
+}
+DumpPacketTraceAction = neewerlight_ns.class_("DumpPacketTraceAction", automation.Action)
+
+
+@automation.register_action(
+    "neewerlight.dump_packet_trace", DumpPacketTraceAction, cv.Schema({})
+)
+async def dump_packet_trace_to_code(config, action_id, template_arg, args):
+    return cg.new_Pvariable(action_id, template_arg)
 
 
 @light_effects.register_rgb_effect(
     "neewer_scene",
     NeewerSceneLightEffect,
     "Neewer FX",
-    {cv.Required("scene_id"): cv.int_range(min=1, max=9)},
+    {
+        cv.Required("scene_id"): cv.int_range(
+            min=1, max=max(len(s["scenes"]) for s in SCENE_SETS.values())
+        )
+    },
 )
 async def neewer_scene_effect_to_code(config, effect_id):
     var = cg.new_Pvariable(effect_id, config[CONF_NAME], config["scene_id"])
     return var
 
 
-RGB62_SCENE_PRESETS = [
-    (1, "Neewer FX • Lighting"),
-    (2, "Neewer FX • Paparazzi"),
-    (3, "Neewer FX • Defective Bulb"),
-    (4, "Neewer FX • Explosion"),
-    (5, "Neewer FX • Welding"),
-    (6, "Neewer FX • CCT Flash"),
-    (7, "Neewer FX • Hue Flash"),
-    (8, "Neewer FX • CCT Pulse"),
-    (9, "Neewer FX • Hue Pulse"),
-]
+def _validate_keyframe(value):
+    has_rgb = any(key in value for key in (CONF_RED, CONF_GREEN, CONF_BLUE))
+    if has_rgb == (CONF_COLOR_TEMPERATURE in value):
+        raise cv.Invalid(
+            f"A keyframe needs either {CONF_RED}/{CONF_GREEN}/{CONF_BLUE} or {CONF_COLOR_TEMPERATURE}"
+        )
+    return value
+
+
+KEYFRAME_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_RED): cv.percentage,
+            cv.Optional(CONF_GREEN): cv.percentage,
+            cv.Optional(CONF_BLUE): cv.percentage,
+            cv.Optional(CONF_COLOR_TEMPERATURE): cv.color_temperature,
+            cv.Optional(CONF_BRIGHTNESS, default=1.0): cv.percentage,
+            cv.Optional(CONF_DURATION, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_EASING, default="linear"): cv.enum(EASINGS, lower=True),
+        }
+    ),
+    _validate_keyframe,
+)
+
+
+def _keyframe_frames(config):
+    # Frames the effect compiles to at its own rate; a light with a lower
+    # max_frame_rate needs fewer.
+    keyframes = config[CONF_KEYFRAMES]
+    segments = keyframes if config[CONF_LOOP] else keyframes[:-1]
+    total_ms = sum(keyframe[CONF_DURATION].total_milliseconds for keyframe in segments)
+    interval_ms = int(1000 / config[CONF_FRAME_RATE])
+    return max(2, math.ceil(total_ms / interval_ms) + 1)
+
+
+@light_effects.register_rgb_effect(
+    "neewer_keyframes",
+    NeewerKeyframeLightEffect,
+    "Neewer Keyframes",
+    {
+        cv.Required(CONF_KEYFRAMES): cv.All(
+            cv.ensure_list(KEYFRAME_SCHEMA), cv.Length(min=2)
+        ),
+        cv.Optional(CONF_LOOP, default=True): cv.boolean,
+        cv.Optional(CONF_FRAME_RATE, default=10.0): cv.float_range(min=1.0, max=50.0),
+        cv.Optional(CONF_MAX_FRAMES): cv.int_range(min=2, max=512),
+    },
+)
+async def neewer_keyframes_effect_to_code(config, effect_id):
+    max_frames = config.get(CONF_MAX_FRAMES, min(_keyframe_frames(config), 128))
+    var = cg.new_Pvariable(effect_id, config[CONF_NAME], max_frames)
+    cg.add(var.set_loop(config[CONF_LOOP]))
+    cg.add(var.set_frame_rate(config[CONF_FRAME_RATE]))
+    for keyframe in config[CONF_KEYFRAMES]:
+        brightness = keyframe[CONF_BRIGHTNESS]
+        if CONF_COLOR_TEMPERATURE in keyframe:
+            channels = (0.0, 0.0, 0.0, keyframe[CONF_COLOR_TEMPERATURE], brightness)
+        else:
+            channels = (
+                keyframe.get(CONF_RED, 0.0) * brightness,
+                keyframe.get(CONF_GREEN, 0.0) * brightness,
+                keyframe.get(CONF_BLUE, 0.0) * brightness,
+                0.0,
+                0.0,
+            )
+        cg.add(
+            var.add_keyframe(
+                *channels,
+                keyframe[CONF_DURATION].total_milliseconds,
+                keyframe[CONF_EASING],
+            )
+        )
+    return var
+
+
+def _model_scenes(model):
+    scene_set = model["scenes"]
+    return SCENE_SETS[scene_set]["scenes"] if scene_set else []
+
+
+def _max_frame_size(model):
+    # Prefix, tag, length and checksum; addressed frames add the MAC and a subtag.
+    overhead = 4 + (7 if model["frame"] == FRAME_ADDRESSED else 0)
+    cct = model["cct"]
+    payloads = [1, 4, 2 + int(cct["gm"]) + len(cct["trailer"])]  # power, HSI, CCT
+    payloads += [1 + len(scene["params"]) for scene in _model_scenes(model)]
+    return overhead + max(payloads)
+
+
+def _validate_model_entry(value):
+    model = MODELS[value]
+    cct = model["cct"]
+    if model["frame"] not in (FRAME_CLASSIC, FRAME_ADDRESSED):
+        raise cv.Invalid(f"models.json: {value} has unknown frame '{model['frame']}'")
+    if cct["encoding"] not in (CCT_MIRED_24, CCT_KELVIN_100):
+        raise cv.Invalid(f"models.json: {value} has unknown CCT encoding '{cct['encoding']}'")
+    if not 0 < cct["kelvin_min"] < cct["kelvin_max"]:
+        raise cv.Invalid(f"models.json: {value} has an invalid kelvin range")
+    for index, scene in enumerate(_model_scenes(model)):
+        if scene["id"] != index + 1:
+            raise cv.Invalid(f"models.json: scenes of {value} must be numbered from 1 in order")
+        if len(scene["params"]) > SCENE_MAX_PARAM_BYTES:
+            raise cv.Invalid(f"models.json: scene '{scene['name']}' has too many parameters")
+        unknown = [param for param in scene["params"] if param not in SCENE_BYTES]
+        if unknown:
+            raise cv.Invalid(f"models.json: scene '{scene['name']}' uses unknown {unknown}")
+    if _max_frame_size(model) > MSG_MAX_SIZE:
+        raise cv.Invalid(
+            f"models.json: {value} frames need {_max_frame_size(model)} bytes, "
+            f"more than MSG_MAX_SIZE ({MSG_MAX_SIZE})"
+        )
+    return value
+
+
+def _cpp_name(key):
+    return re.sub(r"\W", "_", key).upper()
+
+
+def _traits_struct(key):
+    return neewerlight_ns.struct(
+        "Neewer" + "".join(part.capitalize() for part in re.split(r"\W+", key)) + "Model"
+    )
+
+
+def _scene_set_cpp(set_name):
+    rows = []
+    for scene in SCENE_SETS[set_name]["scenes"]:
+        params = "".join(f", NeewerSceneByte::{param.upper()}" for param in scene["params"])
+        rows.append(f"    neewer_scene({scene['id']}, {cpp_string_escape(scene['name'])}{params}),")
+    return "\n".join(
+        [f"static constexpr NeewerSceneDefinition NEEWER_{_cpp_name(set_name)}_SCENES[] = {{"]
+        + rows
+        + ["};"]
+    )
+
+
+def _model_traits_cpp(key):
+    model = MODELS[key]
+    cct = model["cct"]
+    lines = []
+    trailer = "nullptr"
+    if cct["trailer"]:
+        trailer = f"NEEWER_{_cpp_name(key)}_CCT_TRAILER"
+        values = ", ".join(f"0x{byte:02X}" for byte in cct["trailer"])
+        lines.append(f"static constexpr uint8_t {trailer}[] = {{{values}}};")
+    scenes = "nullptr"
+    scene_cct_range = (0, 0)
+    if model["scenes"]:
+        scenes = f"NEEWER_{_cpp_name(model['scenes'])}_SCENES"
+        scene_cct_range = SCENE_SETS[model["scenes"]]["cct_byte_range"]
+
+    def flag(value):
+        return "true" if value else "false"
+
+    lines += [
+        f"struct {_traits_struct(key)} {{",
+        f"  static constexpr const char *NAME = {cpp_string_escape(key)};",
+        f"  static constexpr float KELVIN_MIN = {float(cct['kelvin_min'])}f;",
+        f"  static constexpr float KELVIN_MAX = {float(cct['kelvin_max'])}f;",
+        f"  static constexpr bool CCT_IN_KELVIN = {flag(cct['encoding'] == CCT_KELVIN_100)};",
+        f"  static constexpr bool HAS_GM = {flag(cct['gm'])};",
+        f"  static constexpr const uint8_t *CCT_TRAILER = {trailer};",
+        f"  static constexpr uint8_t CCT_TRAILER_SIZE = {len(cct['trailer'])};",
+        f"  static constexpr bool MAC_PREFIXED = {flag(model['frame'] == FRAME_ADDRESSED)};",
+        f"  static constexpr const NeewerSceneDefinition *SCENES = {scenes};",
+        f"  static constexpr uint8_t SCENE_COUNT = {len(_model_scenes(model))};",
+        f"  static constexpr uint8_t SCENE_CCT_MIN = {scene_cct_range[0]};",
+        f"  static constexpr uint8_t SCENE_CCT_MAX = {scene_cct_range[1]};",
+        f"  static constexpr uint8_t MAX_FRAME_SIZE = {_max_frame_size(model)};",
+        "};",
+    ]
+    return "\n".join(lines)
+
+
+def _add_model_traits(key):
+    # Once per build, however many lights share the model or its scene set.
+    emitted = CORE.data.setdefault("neewerlight", {}).setdefault("models", set())
+    if key in emitted:
+        return
+    parts = []
+    scene_set = MODELS[key]["scenes"]
+    if scene_set and f"scenes:{scene_set}" not in emitted:
+        emitted.add(f"scenes:{scene_set}")
+        parts.append(_scene_set_cpp(scene_set))
+    emitted.add(key)
+    parts.append(_model_traits_cpp(key))
+    body = "\n".join(parts)
+    cg.add_global(
+        cg.RawStatement(
+            f"namespace esphome {{\nnamespace neewerlight {{\n{body}\n}}  // namespace neewerlight\n"
+            f"}}  // namespace esphome"
+        )
+    )
 
 
 def _inject_scene_effects(value):
-    if value.get(CONF_MODEL) != MODEL_RGB62:
+    model = MODELS.get(str(value.get(CONF_MODEL, "")).lower())
+    if model is None or not model["scenes"]:
         return value
 
     effects = value.setdefault(CONF_EFFECTS, [])
@@ -63,14 +315,78 @@ def _inject_scene_effects(value):
         if isinstance(entry, dict) and "neewer_scene" in entry
     }
 
-    for scene_id, name in RGB62_SCENE_PRESETS:
-        if scene_id in existing:
+    for scene in _model_scenes(model):
+        if scene["id"] in existing:
             continue
-        effects.append({"neewer_scene": {CONF_NAME: name, "scene_id": scene_id}})
+        effects.append(
+            {"neewer_scene": {CONF_NAME: f"Neewer FX • {scene['name']}", "scene_id": scene["id"]}}
+        )
+
+    return value
+
 
+def _validate_conn_params(value):
+    min_us = value[CONF_MIN_INTERVAL].total_microseconds
+    max_us = value[CONF_MAX_INTERVAL].total_microseconds
+    if min_us > max_us:
+        raise cv.Invalid(f"{CONF_MIN_INTERVAL} must not exceed {CONF_MAX_INTERVAL}")
+    # Bluetooth Core spec: the supervision timeout must outlast two effective intervals.
+    if value[CONF_TIMEOUT].total_microseconds <= (1 + value[CONF_LATENCY]) * max_us * 2:
+        raise cv.Invalid(
+            f"{CONF_TIMEOUT} must be longer than (1 + {CONF_LATENCY}) * {CONF_MAX_INTERVAL} * 2"
+        )
     return value
 
 
+def _conn_params_schema(min_interval, max_interval, latency, timeout):
+    interval = cv.All(
+        cv.positive_time_period_microseconds,
+        cv.Range(min=cv.TimePeriod(microseconds=7500), max=cv.TimePeriod(seconds=4)),
+    )
+    return cv.All(
+        cv.Schema(
+            {
+                cv.Optional(CONF_MIN_INTERVAL, default=min_interval): interval,
+                cv.Optional(CONF_MAX_INTERVAL, default=max_interval): interval,
+                cv.Optional(CONF_LATENCY, default=latency): cv.int_range(min=0, max=499),
+                cv.Optional(CONF_TIMEOUT, default=timeout): cv.All(
+                    cv.positive_time_period_milliseconds,
+                    cv.Range(
+                        min=cv.TimePeriod(milliseconds=100), max=cv.TimePeriod(seconds=32)
+                    ),
+                ),
+            }
+        ),
+        _validate_conn_params,
+    )
+
+
+CONNECTION_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_ACTIVE, default={}): _conn_params_schema(
+            "15ms", "30ms", 0, "2s"
+        ),
+        cv.Optional(CONF_IDLE, default={}): _conn_params_schema(
+            "100ms", "200ms", 4, "6s"
+        ),
+        cv.Optional(
+            CONF_IDLE_AFTER, default="10s"
+        ): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MTU, default=64): cv.int_range(min=23, max=517),
+    }
+)
+
+
+def _conn_params_args(params):
+    # Controller units: 1.25 ms per interval step, 10 ms per timeout step.
+    return (
+        round(params[CONF_MIN_INTERVAL].total_microseconds / 1250),
+        round(params[CONF_MAX_INTERVAL].total_microseconds / 1250),
+        params[CONF_LATENCY],
+        params[CONF_TIMEOUT].total_milliseconds // 10,
+    )
+
+
 DEPENDENCIES = ["ble_client"]
 AUTO_LOAD = ["output", "rgbct"]
 IS_PLATFORM_COMPONENT = True
@@ -82,19 +398,36 @@ NeewerRGBCTLightOutput = neewerlight_ns.class_(
     rgbct_light.RGBCTLightOutput,
     nw_output.NeewerBLEOutput,
 )
+NeewerModelLightOutput = neewerlight_ns.class_(
+    "NeewerModelLightOutput", NeewerRGBCTLightOutput
+)
 
 _BASE_SCHEMA = (
     cv.Schema(
         {
-            cv.GenerateID(CONF_OUTPUT_ID): cv.declare_id(NeewerRGBCTLightOutput),
+            cv.GenerateID(CONF_OUTPUT_ID): cv.declare_id(NeewerModelLightOutput),
             cv.Required(CONF_NAME): cv.string,
             cv.Required(ble_client.CONF_BLE_CLIENT_ID): cv.use_id(ble_client.BLEClient),
             cv.Optional(CONF_GAMMA_CORRECT, default=1.0): cv.positive_float,
             cv.Optional(CONF_COLOR_INTERLOCK, default=True): cv.boolean,
-            cv.Required(CONF_MODEL): cv.one_of(MODEL_RGB62, lower=True),
+            cv.Required(CONF_MODEL): cv.All(
+                cv.one_of(*MODELS, lower=True), _validate_model_entry
+            ),
             cv.Optional(CONF_GREEN_MAGENTA_BIAS, default=0.0): cv.float_range(
                 min=-50.0, max=50.0
             ),
+            cv.Optional(CONF_REQUIRE_RESPONSE, default=True): cv.boolean,
+            cv.Optional(CONF_MAX_FRAME_RATE, default=10.0): cv.float_range(
+                min=1.0, max=50.0
+            ),
+            cv.Optional(CONF_PACKET_TRACE, default=False): cv.boolean,
+            cv.Optional(CONF_STATS_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_STATUS_VERIFY_DELAY, default="1s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_TRACK_CHANNEL, default=False): cv.boolean,
+            cv.Optional(CONF_STATUS_POLL_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_CONNECTION): CONNECTION_SCHEMA,
         }
     )
     .extend(cv.ENTITY_BASE_SCHEMA)
@@ -105,18 +438,53 @@ _BASE_SCHEMA = (
 CONFIG_SCHEMA = cv.All(_inject_scene_effects, _BASE_SCHEMA)
 
 
+def _final_validate(config):
+    # The local MTU is a single setting of the BLE stack, applied once before the
+    # first light connects, so every light that sets one has to agree on it.
+    if CONF_CONNECTION not in config:
+        return config
+    mtu = config[CONF_CONNECTION][CONF_MTU]
+    for other in fv.full_config.get().get(CONF_LIGHT, []):
+        if other.get(CONF_PLATFORM) != "neewerlight" or CONF_CONNECTION not in other:
+            continue
+        other_mtu = other[CONF_CONNECTION][CONF_MTU]
+        if other_mtu != mtu:
+            raise cv.Invalid(
+                f"connection mtu {mtu} conflicts with {other_mtu} on light '{other[CONF_NAME]}'; "
+                "the MTU is shared by every BLE connection, so all lights must use the same value",
+                path=[CONF_CONNECTION, CONF_MTU],
+            )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+
 async def to_code(config):
-    var = cg.new_Pvariable(config[CONF_OUTPUT_ID])
+    _add_model_traits(config[CONF_MODEL])
+    var = cg.new_Pvariable(
+        config[CONF_OUTPUT_ID], cg.TemplateArguments(_traits_struct(config[CONF_MODEL]))
+    )
     await light.register_light(var, config)
 
     await ble_client.register_ble_node(var, config)
 
     cg.add(var.set_color_interlock(config[CONF_COLOR_INTERLOCK]))
-    cg.add(var.set_kelvin_range(3200.0, 5600.0))
-    cg.add(var.set_supports_green_magenta(False))
     cg.add(var.set_green_magenta_bias(config[CONF_GREEN_MAGENTA_BIAS]))
-    if config[CONF_MODEL] == MODEL_RGB62:
-        cg.add(var.set_kelvin_range(RGB62_MIN_KELVIN, RGB62_MAX_KELVIN))
-        cg.add(var.set_cold_white_temperature(RGB62_COLD_WHITE_MIRED))
-        cg.add(var.set_warm_white_temperature(RGB62_WARM_WHITE_MIRED))
-        cg.add(var.set_supports_green_magenta(True))
+    cg.add(var.set_require_response(config[CONF_REQUIRE_RESPONSE]))
+    cg.add(var.set_max_frame_rate(config[CONF_MAX_FRAME_RATE]))
+    if config[CONF_PACKET_TRACE]:
+        cg.add_define("USE_NEEWER_PACKET_TRACE")
+        cg.add(var.set_packet_trace(True))
+    if CONF_STATS_INTERVAL in config:
+        cg.add(var.set_stats_interval(config[CONF_STATS_INTERVAL]))
+    cg.add(var.set_status_verify_delay(config[CONF_STATUS_VERIFY_DELAY]))
+    cg.add(var.set_track_channel(config[CONF_TRACK_CHANNEL]))
+    if CONF_STATUS_POLL_INTERVAL in config:
+        cg.add(var.set_status_poll_interval(config[CONF_STATUS_POLL_INTERVAL]))
+    if CONF_CONNECTION in config:
+        connection = config[CONF_CONNECTION]
+        cg.add(var.set_active_conn_params(*_conn_params_args(connection[CONF_ACTIVE])))
+        cg.add(var.set_idle_conn_params(*_conn_params_args(connection[CONF_IDLE])))
+        cg.add(var.set_idle_after(connection[CONF_IDLE_AFTER]))
+        cg.add(var.set_mtu(connection[CONF_MTU]))
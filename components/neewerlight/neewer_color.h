@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace neewerlight {
+
+// Fixed-point RGB -> HSI for the 0x86 frame. Channels are taken as 0.0-1.0 floats,
+// scaled once to 24 bits, and everything after that is integer math, so it stays
+// cheap on FPU-less parts (ESP32-C3). Results are wire-ready: hue 0-359, saturation
+// and brightness 0-100, all within 1 LSB of the original float implementation.
+// Hue and saturation truncate like it did; brightness rounds to the nearest
+// percent, the grid snap_to_device_resolution_ puts targets on. Self-contained
+// so it can be built on a host.
+inline void neewer_rgb_to_hsi(float red, float green, float blue, uint16_t *hue, uint8_t *saturation,
+                              uint8_t *brightness) {
+  static const int32_t ONE = 0xFFFFFF;
+  auto to_fixed = [](float value) -> int32_t {
+    if (!(value > 0.0f))  // also catches NaN
+      return 0;
+    if (value >= 1.0f)
+      return ONE;
+    return static_cast<int32_t>(value * static_cast<float>(ONE) + 0.5f);
+  };
+  // Floor division; the numerator may be negative, the denominator never is.
+  auto floor_div = [](int32_t numerator, int32_t denominator) -> int32_t {
+    const int32_t quotient = numerator / denominator;
+    return (numerator % denominator != 0 && numerator < 0) ? quotient - 1 : quotient;
+  };
+  const int32_t r = to_fixed(red);
+  const int32_t g = to_fixed(green);
+  const int32_t b = to_fixed(blue);
+
+  const int32_t max_value = r > g ? (r > b ? r : b) : (g > b ? g : b);
+  const int32_t min_value = r < g ? (r < b ? r : b) : (g < b ? g : b);
+  const int32_t diff = max_value - min_value;
+
+  *brightness = static_cast<uint8_t>((max_value * 100 + ONE / 2) / ONE);
+  *saturation = max_value == 0 ? 0 : static_cast<uint8_t>((diff * 100) / max_value);
+
+  if (diff == 0) {
+    *hue = 0;
+    return;
+  }
+  // Same sector order as the float version (red, then green, then blue wins ties).
+  // The red sector truncates toward zero before wrapping, like the old (int) cast;
+  // the others are always positive, where truncation is a floor. 60 * 2^24 still
+  // fits in 32 bits, which is why the sector offset is added after dividing.
+  int32_t degrees;
+  if (max_value == r) {
+    degrees = (60 * (g - b)) / diff;
+    if (degrees < 0)
+      degrees += 360;
+  } else if (max_value == g) {
+    degrees = 120 + floor_div(60 * (b - r), diff);
+  } else {
+    degrees = 240 + floor_div(60 * (r - g), diff);
+  }
+  if (degrees >= 360)
+    degrees -= 360;
+  *hue = static_cast<uint16_t>(degrees);
+}
+
+}  // namespace neewerlight
+}  // namespace esphome
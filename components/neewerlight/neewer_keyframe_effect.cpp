@@ -0,0 +1,165 @@
+#include "neewer_keyframe_effect.h"
+#include "../../core/hal.h"
+#include "../../core/helpers.h"
+#include "../../core/log.h"
+
+#include <algorithm>
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight {
+
+static const char *const TAG = "neewer_keyframe_effect";
+
+static float ease(NeewerEasing easing, float x) {
+  switch (easing) {
+    case NeewerEasing::EASE_IN:
+      return x * x;
+    case NeewerEasing::EASE_OUT:
+      return x * (2.0f - x);
+    case NeewerEasing::EASE_IN_OUT:
+      return x * x * (3.0f - 2.0f * x);
+    case NeewerEasing::STEP:
+      return 0.0f;
+    case NeewerEasing::LINEAR:
+    default:
+      return x;
+  }
+}
+
+NeewerKeyframeLightEffect::NeewerKeyframeLightEffect(const char *name, uint16_t max_frames)
+    : light_ns::LightEffect(name), max_frames_(max_frames) {}
+
+void NeewerKeyframeLightEffect::add_keyframe(float red, float green, float blue, float color_temperature,
+                                             float white_brightness, uint32_t duration_ms, NeewerEasing easing) {
+  this->keyframes_.push_back({red, green, blue, color_temperature, white_brightness, duration_ms, easing});
+}
+
+void NeewerKeyframeLightEffect::start() {
+  auto *state = this->get_light_state();
+  if (state == nullptr || this->keyframes_.empty())
+    return;
+  this->output_ = static_cast<NeewerRGBCTLightOutput *>(state->get_output());
+  if (this->output_ == nullptr)
+    return;
+  this->compile_();
+  this->start_ms_ = millis();
+  this->sent_any_ = false;
+  this->finished_ = false;
+  this->frames_sent_ = 0;
+  this->frames_skipped_ = 0;
+}
+
+void NeewerKeyframeLightEffect::stop() {
+  if (this->output_ != nullptr) {
+    ESP_LOGD(TAG, "Effect stopped: %u frames sent, %u skipped on a busy link", this->frames_sent_,
+             this->frames_skipped_);
+  }
+  this->output_ = nullptr;
+  // Lights with several effects configured only pay for the one that runs.
+  std::vector<NeewerEffectFrame>().swap(this->frames_);
+}
+
+// Runs every main loop iteration while the effect is active: integer time math
+// and a table lookup, nothing else.
+void NeewerKeyframeLightEffect::apply() {
+  if (this->output_ == nullptr || this->frames_.empty() || this->finished_)
+    return;
+  const uint32_t tick = (millis() - this->start_ms_) / this->interval_ms_;
+  if (this->sent_any_ && tick == this->last_tick_)
+    return;
+  if (!this->output_->link_idle())
+    return;
+
+  const uint32_t count = this->frames_.size();
+  uint32_t index = tick;
+  if (index >= count) {
+    if (!this->loop_) {
+      index = count - 1;
+      this->finished_ = true;
+    } else {
+      index %= count;
+    }
+  } else if (!this->loop_ && index == count - 1) {
+    this->finished_ = true;
+  }
+  if (this->sent_any_ && tick > this->last_tick_ + 1)
+    this->frames_skipped_ += tick - this->last_tick_ - 1;
+
+  const NeewerEffectFrame &frame = this->frames_[index];
+  this->output_->apply_target(frame.target, frame.frame, frame.frame_class, NeewerPriority::EFFECT);
+  this->last_tick_ = tick;
+  this->sent_any_ = true;
+  this->frames_sent_++;
+}
+
+// Sample the keyframes once per frame interval and encode every sample. A looping
+// effect covers every segment including the one back to the first stop; a
+// one-shot effect ends on a frame holding the last stop.
+void NeewerKeyframeLightEffect::compile_() {
+  const uint32_t compile_start = micros();
+  const size_t stops = this->keyframes_.size();
+  const size_t segments = this->loop_ ? stops : stops - 1;
+  uint32_t total_ms = 0;
+  for (size_t i = 0; i < segments; i++)
+    total_ms += this->keyframes_[i].duration_ms;
+
+  const uint32_t min_interval_ms = this->output_->get_min_frame_interval();
+  this->interval_ms_ = std::max(std::max(this->frame_interval_ms_, min_interval_ms), static_cast<uint32_t>(1));
+  const uint32_t capacity = this->loop_ ? this->max_frames_ : this->max_frames_ - 1;
+  if ((total_ms + this->interval_ms_ - 1) / this->interval_ms_ > capacity) {
+    this->interval_ms_ = (total_ms + capacity - 1) / capacity;
+    ESP_LOGW(TAG, "Effect needs more than %u frames, frame interval raised to %ums", this->max_frames_,
+             this->interval_ms_);
+  }
+  uint32_t frame_count = (total_ms + this->interval_ms_ - 1) / this->interval_ms_;
+  if (!this->loop_ || frame_count == 0)
+    frame_count++;
+
+  // The only allocation; stop() releases it.
+  this->frames_.clear();
+  this->frames_.reserve(frame_count);
+  for (uint32_t i = 0; i < frame_count; i++) {
+    NeewerEffectFrame frame;
+    frame.target.on = true;
+    this->sample_(std::min(i * this->interval_ms_, total_ms), &frame.target);
+    frame.frame_class = this->output_->encode_frame(&frame.target, &frame.frame);
+    this->frames_.push_back(frame);
+  }
+  ESP_LOGD(TAG, "Effect compiled to %u frames at %ums in %uus", frame_count, this->interval_ms_,
+           micros() - compile_start);
+}
+
+void NeewerKeyframeLightEffect::sample_(uint32_t time_ms, NeewerLightTarget *target) const {
+  const size_t stops = this->keyframes_.size();
+  size_t index = 0;
+  uint32_t segment_start = 0;
+  while (index + 1 < stops && time_ms >= segment_start + this->keyframes_[index].duration_ms) {
+    segment_start += this->keyframes_[index].duration_ms;
+    index++;
+  }
+  const NeewerKeyframe &from = this->keyframes_[index];
+  const bool has_next = this->loop_ || index + 1 < stops;
+  const NeewerKeyframe &to = has_next ? this->keyframes_[(index + 1) % stops] : from;
+
+  float progress = 0.0f;
+  if (has_next && from.duration_ms > 0)
+    progress = ease(from.easing, clamp(static_cast<float>(time_ms - segment_start) / from.duration_ms, 0.0f, 1.0f));
+  auto lerp = [progress](float a, float b) { return a + (b - a) * progress; };
+
+  // A colour stop has no colour temperature of its own; it takes the other end's.
+  const float from_ct = from.color_temperature > 0.0f ? from.color_temperature : to.color_temperature;
+  const float to_ct = to.color_temperature > 0.0f ? to.color_temperature : from_ct;
+  target->red = lerp(from.red, to.red);
+  target->green = lerp(from.green, to.green);
+  target->blue = lerp(from.blue, to.blue);
+  target->white_brightness = lerp(from.white_brightness, to.white_brightness);
+  const float mireds = lerp(from_ct, to_ct);
+  target->color_temperature = mireds > 0.0f ? this->output_->normalize_color_temperature(mireds) : 0.5f;
+}
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32
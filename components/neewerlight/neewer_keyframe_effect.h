@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../light/light_effect.h"
+#include "neewer_light_output.h"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight {
+
+enum class NeewerEasing : uint8_t {
+    LINEAR = 0,
+    EASE_IN,
+    EASE_OUT,
+    EASE_IN_OUT,
+    STEP,  // hold until the next stop
+};
+
+// One stop of a keyframe effect. Colour stops carry RGB at their brightness and
+// leave color_temperature at 0; white stops carry mireds and white_brightness.
+struct NeewerKeyframe {
+    float red;
+    float green;
+    float blue;
+    float color_temperature;  // mireds
+    float white_brightness;
+    uint32_t duration_ms;  // time spent moving from this stop to the next
+    NeewerEasing easing;
+};
+
+// One sample of a compiled effect, encoded and checksummed for the light.
+struct NeewerEffectFrame {
+    NeewerLightTarget target;
+    NeewerPacket frame;
+    NeewerCommandClass frame_class;
+};
+
+// Custom animation for a neewerlight. start() samples the keyframes at the
+// effect's frame rate (never faster than the light's max_frame_rate) and encodes
+// every sample into a table sized for this run; stop() frees it again, so an
+// effect only holds RAM while it runs. apply() only picks the frame due at the
+// current time and hands it over once the light's link is idle.
+// A frame that falls due while a write is still in flight is skipped rather
+// than queued, so a slow link drops frames but keeps the effect's timing.
+class NeewerKeyframeLightEffect : public light_ns::LightEffect {
+ public:
+  NeewerKeyframeLightEffect(const char *name, uint16_t max_frames);
+  void add_keyframe(float red, float green, float blue, float color_temperature, float white_brightness,
+                    uint32_t duration_ms, NeewerEasing easing);
+  void set_loop(bool loop) { this->loop_ = loop; }
+  void set_frame_rate(float frames_per_second) {
+    this->frame_interval_ms_ = static_cast<uint32_t>(1000.0f / frames_per_second);
+  }
+
+  void start() override;
+  void stop() override;
+  void apply() override;
+
+ protected:
+  void compile_();
+  void sample_(uint32_t time_ms, NeewerLightTarget *target) const;
+
+  std::vector<NeewerKeyframe> keyframes_;
+  std::vector<NeewerEffectFrame> frames_;
+  uint16_t max_frames_;
+  bool loop_ = true;
+  uint32_t frame_interval_ms_ = 100;
+  NeewerRGBCTLightOutput *output_ = nullptr;
+  uint32_t interval_ms_ = 100;  // effective, after the light's rate limit and max_frames
+  uint32_t start_ms_ = 0;
+  uint32_t last_tick_ = 0;
+  bool sent_any_ = false;
+  bool finished_ = false;
+  uint32_t frames_sent_ = 0;
+  uint32_t frames_skipped_ = 0;
+};
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,50 @@
+#include "neewer_latency.h"
+
+#include <cmath>
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight {
+
+// Upper bound of every bucket but the last, in ms.
+static const uint16_t LATENCY_BUCKET_LIMITS_MS[LATENCY_BUCKET_COUNT - 1] = {
+    5, 10, 15, 20, 30, 40, 50, 75, 100, 150, 200, 300, 400, 500, 750, 1000, 1500, 2000, 3000,
+};
+
+void NeewerLatencyHistogram::record(uint32_t latency_us) {
+  const uint32_t latency_ms = latency_us / 1000;
+  uint8_t bucket = 0;
+  while (bucket < LATENCY_BUCKET_COUNT - 1 && latency_ms >= LATENCY_BUCKET_LIMITS_MS[bucket])
+    bucket++;
+  this->counts[bucket]++;
+}
+
+float NeewerLatencyHistogram::percentile_since(const NeewerLatencyHistogram &before, float percentile) const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    total += this->counts[i] - before.counts[i];
+  if (total == 0)
+    return NAN;
+
+  const float rank = percentile * total;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+    const uint32_t count = this->counts[i] - before.counts[i];
+    if (count == 0 || seen + count < rank) {
+      seen += count;
+      continue;
+    }
+    const float lower = i == 0 ? 0.0f : LATENCY_BUCKET_LIMITS_MS[i - 1];
+    if (i == LATENCY_BUCKET_COUNT - 1)
+      return lower;  // open-ended: report the bound it is above
+    const float upper = LATENCY_BUCKET_LIMITS_MS[i];
+    return lower + (upper - lower) * (rank - seen) / count;
+  }
+  return LATENCY_BUCKET_LIMITS_MS[LATENCY_BUCKET_COUNT - 2];
+}
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32
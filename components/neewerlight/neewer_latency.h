@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight {
+
+// Points a command's latency is measured to. WRITE and ACK run from the light
+// call (or, for frames not produced by write_state, the moment the frame was
+// queued); CONFIRM is the round trip of the status query that verifies it.
+enum class NeewerLatencyStage : uint8_t {
+    WRITE = 0,  // frame handed to the BLE stack
+    ACK,        // ESP_GATTC_WRITE_CHAR_EVT for the frame
+    CONFIRM,    // power status query sent after the ack, to its notify
+};
+static const uint8_t LATENCY_STAGE_COUNT = 3;
+
+// Fixed buckets, from 5 ms steps at the short end to an open-ended last bucket
+// above 3 s. Counts only grow; readers diff two snapshots for a window.
+static const uint8_t LATENCY_BUCKET_COUNT = 20;
+
+struct NeewerLatencyHistogram {
+    uint32_t counts[LATENCY_BUCKET_COUNT] = {};
+
+    void record(uint32_t latency_us);
+    // Interpolated percentile (0-1) in ms of the samples recorded since
+    // `before`, a copy of this histogram taken earlier. NAN when there are none.
+    float percentile_since(const NeewerLatencyHistogram &before, float percentile) const;
+};
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32
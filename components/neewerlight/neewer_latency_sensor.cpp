@@ -0,0 +1,60 @@
+#include "neewer_latency_sensor.h"
+
+#if defined(USE_ESP32) && defined(USE_SENSOR)
+
+#include "../../core/hal.h"
+
+namespace esphome {
+namespace neewerlight {
+
+static const char *const STAGE_NAMES[LATENCY_STAGE_COUNT] = {"write", "ack", "confirm"};
+
+void NeewerLatencySensor::setup() {
+  this->previous_ = this->output_->get_latency(this->stage_);
+  this->previous_frames_ = this->output_->get_stats().frames_sent;
+  this->previous_ms_ = millis();
+}
+
+void NeewerLatencySensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "Neewer latency sensor:");
+  ESP_LOGCONFIG(TAG, "  Light              : %u", this->output_->get_light_id());
+  ESP_LOGCONFIG(TAG, "  Measured to        : %s", STAGE_NAMES[static_cast<uint8_t>(this->stage_)]);
+  LOG_SENSOR("  ", "Latency p50", this->p50_sensor_);
+  LOG_SENSOR("  ", "Latency p95", this->p95_sensor_);
+  LOG_SENSOR("  ", "Latency p99", this->p99_sensor_);
+  LOG_SENSOR("  ", "Writes per second", this->writes_per_second_sensor_);
+  LOG_SENSOR("  ", "Write failures", this->write_failures_sensor_);
+  LOG_SENSOR("  ", "Status timeouts", this->status_timeouts_sensor_);
+}
+
+// Percentiles are NAN (unknown) for a window without commands, so an idle light
+// doesn't keep reporting a stale figure.
+void NeewerLatencySensor::update() {
+  const NeewerLatencyHistogram &latency = this->output_->get_latency(this->stage_);
+  if (this->p50_sensor_ != nullptr)
+    this->p50_sensor_->publish_state(latency.percentile_since(this->previous_, 0.50f));
+  if (this->p95_sensor_ != nullptr)
+    this->p95_sensor_->publish_state(latency.percentile_since(this->previous_, 0.95f));
+  if (this->p99_sensor_ != nullptr)
+    this->p99_sensor_->publish_state(latency.percentile_since(this->previous_, 0.99f));
+  this->previous_ = latency;
+
+  const auto &stats = this->output_->get_stats();
+  const uint32_t now = millis();
+  if (this->writes_per_second_sensor_ != nullptr && now != this->previous_ms_) {
+    this->writes_per_second_sensor_->publish_state((stats.frames_sent - this->previous_frames_) * 1000.0f /
+                                                   (now - this->previous_ms_));
+  }
+  this->previous_frames_ = stats.frames_sent;
+  this->previous_ms_ = now;
+
+  if (this->write_failures_sensor_ != nullptr)
+    this->write_failures_sensor_->publish_state(stats.write_failures);
+  if (this->status_timeouts_sensor_ != nullptr)
+    this->status_timeouts_sensor_->publish_state(stats.status_timeouts);
+}
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32 && USE_SENSOR
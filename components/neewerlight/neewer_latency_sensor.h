@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../../core/defines.h"
+
+#if defined(USE_ESP32) && defined(USE_SENSOR)
+
+#include "../sensor/sensor.h"
+#include "../../core/component.h"
+#include "neewer_light_output.h"
+
+namespace esphome {
+namespace neewerlight {
+
+// Link health of one light as sensor entities. Every update_interval it
+// publishes latency percentiles of the commands that landed since the previous
+// update, the write rate over the same window, and running totals of failed
+// writes and status timeouts.
+class NeewerLatencySensor : public PollingComponent {
+ public:
+    void set_output(NeewerBLEOutput *output) { this->output_ = output; }
+    void set_stage(NeewerLatencyStage stage) { this->stage_ = stage; }
+    void set_p50_sensor(sensor::Sensor *sensor) { this->p50_sensor_ = sensor; }
+    void set_p95_sensor(sensor::Sensor *sensor) { this->p95_sensor_ = sensor; }
+    void set_p99_sensor(sensor::Sensor *sensor) { this->p99_sensor_ = sensor; }
+    void set_writes_per_second_sensor(sensor::Sensor *sensor) { this->writes_per_second_sensor_ = sensor; }
+    void set_write_failures_sensor(sensor::Sensor *sensor) { this->write_failures_sensor_ = sensor; }
+    void set_status_timeouts_sensor(sensor::Sensor *sensor) { this->status_timeouts_sensor_ = sensor; }
+
+    void setup() override;
+    void update() override;
+    void dump_config() override;
+
+ protected:
+    NeewerBLEOutput *output_ = nullptr;
+    NeewerLatencyStage stage_ = NeewerLatencyStage::ACK;
+    sensor::Sensor *p50_sensor_ = nullptr;
+    sensor::Sensor *p95_sensor_ = nullptr;
+    sensor::Sensor *p99_sensor_ = nullptr;
+    sensor::Sensor *writes_per_second_sensor_ = nullptr;
+    sensor::Sensor *write_failures_sensor_ = nullptr;
+    sensor::Sensor *status_timeouts_sensor_ = nullptr;
+
+    // Snapshot at the previous update; the window is everything since.
+    NeewerLatencyHistogram previous_;
+    uint32_t previous_frames_ = 0;
+    uint32_t previous_ms_ = 0;
+
+    const char* const TAG = "neewer_latency_sensor";
+};
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32 && USE_SENSOR
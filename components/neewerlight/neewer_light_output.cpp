@@ -1,90 +1,20 @@
 #include "neewer_light_output.h"
 
+#include <algorithm>
+#include <cstring>
+
 #ifdef USE_ESP32
 
 namespace esphome {
 namespace neewerlight {
 
-namespace {
-constexpr uint8_t POWER_STATUS_REQUEST_TAG = 0x85;
-constexpr uint8_t CHANNEL_STATUS_REQUEST_TAG = 0x84;
-constexpr uint8_t POWER_STATUS_RESPONSE_TAG = 0x02;
-constexpr uint8_t CHANNEL_STATUS_RESPONSE_TAG = 0x01;
-constexpr uint8_t FX_SUBTAG = 0x8B;
-
-const NeewerSceneParamSpec FX1_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::CCT},
-    {NeewerSceneParamKind::SPEED},
-};
-const NeewerSceneParamSpec FX2_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::CCT},
-    {NeewerSceneParamKind::GM},
-    {NeewerSceneParamKind::SPEED},
-};
-const NeewerSceneParamSpec FX3_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::CCT},
-    {NeewerSceneParamKind::GM},
-    {NeewerSceneParamKind::SPEED},
-};
-const NeewerSceneParamSpec FX4_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::CCT},
-    {NeewerSceneParamKind::GM},
-    {NeewerSceneParamKind::SPEED},
-    {NeewerSceneParamKind::SPARKS},
-};
-const NeewerSceneParamSpec FX5_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::CCT},
-    {NeewerSceneParamKind::GM},
-    {NeewerSceneParamKind::SPEED},
-};
-const NeewerSceneParamSpec FX6_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::CCT},
-    {NeewerSceneParamKind::GM},
-    {NeewerSceneParamKind::SPEED},
-};
-const NeewerSceneParamSpec FX7_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::HUE16},
-    {NeewerSceneParamKind::SAT},
-    {NeewerSceneParamKind::SPEED},
-};
-const NeewerSceneParamSpec FX8_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::CCT},
-    {NeewerSceneParamKind::GM},
-    {NeewerSceneParamKind::SPEED},
-};
-const NeewerSceneParamSpec FX9_PARAMS[] = {
-    {NeewerSceneParamKind::BRR},
-    {NeewerSceneParamKind::HUE16},
-    {NeewerSceneParamKind::SAT},
-    {NeewerSceneParamKind::SPEED},
-};
-
-const NeewerSceneDefinition NEEWER_SIMPLE_SCENES[] = {
-    {1, "Neewer FX • Lighting", FX1_PARAMS, static_cast<uint8_t>(sizeof(FX1_PARAMS) / sizeof(FX1_PARAMS[0]))},
-    {2, "Neewer FX • Paparazzi", FX2_PARAMS, static_cast<uint8_t>(sizeof(FX2_PARAMS) / sizeof(FX2_PARAMS[0]))},
-    {3, "Neewer FX • Defective Bulb", FX3_PARAMS, static_cast<uint8_t>(sizeof(FX3_PARAMS) / sizeof(FX3_PARAMS[0]))},
-    {4, "Neewer FX • Explosion", FX4_PARAMS, static_cast<uint8_t>(sizeof(FX4_PARAMS) / sizeof(FX4_PARAMS[0]))},
-    {5, "Neewer FX • Welding", FX5_PARAMS, static_cast<uint8_t>(sizeof(FX5_PARAMS) / sizeof(FX5_PARAMS[0]))},
-    {6, "Neewer FX • CCT Flash", FX6_PARAMS, static_cast<uint8_t>(sizeof(FX6_PARAMS) / sizeof(FX6_PARAMS[0]))},
-    {7, "Neewer FX • Hue Flash", FX7_PARAMS, static_cast<uint8_t>(sizeof(FX7_PARAMS) / sizeof(FX7_PARAMS[0]))},
-    {8, "Neewer FX • CCT Pulse", FX8_PARAMS, static_cast<uint8_t>(sizeof(FX8_PARAMS) / sizeof(FX8_PARAMS[0]))},
-    {9, "Neewer FX • Hue Pulse", FX9_PARAMS, static_cast<uint8_t>(sizeof(FX9_PARAMS) / sizeof(FX9_PARAMS[0]))},
-};
-
-constexpr size_t NEEWER_SIMPLE_SCENE_COUNT = sizeof(NEEWER_SIMPLE_SCENES) / sizeof(NEEWER_SIMPLE_SCENES[0]);
-}  // namespace
+uint8_t NeewerBLEOutput::next_light_id_ = 0;
+bool NeewerBLEOutput::local_mtu_set_ = false;
 
 void NeewerBLEOutput::dump_config() {
   ESP_LOGCONFIG(TAG, "Neewer BLE Output:");
   ESP_LOGCONFIG(TAG, "  MAC address        : %s", this->parent_->address_str());
+  ESP_LOGCONFIG(TAG, "  Trace light id     : %u%s", this->light_id_, this->packet_trace_ ? "" : " (not traced)");
   ESP_LOGCONFIG(TAG, "  Service UUID       : %s", this->service_uuid_.to_string().c_str());
   ESP_LOGCONFIG(TAG, "  Characteristic UUID: %s", this->char_uuid_.to_string().c_str());
   LOG_BINARY_OUTPUT(this);
@@ -95,41 +25,115 @@ void NeewerBLEOutput::gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_i
   ESP_LOGD(TAG, "BLE event received: %d", event);
   
   switch (event) {
+    case ESP_GATTC_REG_EVT:
+      // The local MTU is one setting for the whole stack (light.py makes every
+      // light agree on it). Set it once, when the first client registers and
+      // before any connection; ble_client's own MTU exchange then asks for it.
+      if (this->mtu_ != 0 && !local_mtu_set_ && param->reg.status == ESP_GATT_OK) {
+        esp_err_t mtu_status = esp_ble_gatt_set_local_mtu(this->mtu_);
+        if (mtu_status != ESP_OK)
+          ESP_LOGW(TAG, "Setting the local MTU to %u failed, status=%d", this->mtu_, mtu_status);
+        local_mtu_set_ = true;
+      }
+      break;
     case ESP_GATTC_OPEN_EVT:
       this->client_state_ = espbt::ClientState::ESTABLISHED;
       ESP_LOGI(TAG, "BLE connection established to Neewer RGB660");
       ESP_LOGD(TAG, "Connection details - Interface: %d, Connection ID: %d", gattc_if, param->open.conn_id);
+      this->connected_ms_ = millis();
+      // A fresh connection is about to carry state, so start on the active profile.
+      this->last_activity_ms_ = millis();
+      this->request_conn_profile_(NeewerConnProfile::ACTIVE);
+      this->try_cached_handles_(gattc_if);
+      break;
+    case ESP_GATTC_SEARCH_CMPL_EVT:
+      if (this->handles_ready_) {
+        // Already running on cached handles; just make sure discovery agrees.
+        this->check_cached_handles_();
+        break;
+      }
+      // Cached handles, if any, were not confirmed in time; trust discovery instead.
+      this->cache_validating_ = false;
+      this->write_handle_ = 0;
+      // Services are known from here on; resolve every handle once.
+      // Resync first, so status queries queued below read back the resynced state.
+      if (this->resolve_write_handle_())
+        this->mark_handles_ready_("discovered");
       if (!this->notify_registered_ && this->register_for_notifications_(gattc_if)) {
         this->status_notifications_ready_();
+        this->save_handle_cache_();
+      }
+      break;
+    case ESP_GATTC_WRITE_DESCR_EVT: {
+      if (!this->cache_validating_ || param->write.handle != this->notify_cccd_handle_)
+        break;
+      // The CCCD write on the cached handle doubles as the validation step.
+      this->cache_validating_ = false;
+      if (param->write.status != ESP_GATT_OK) {
+        ESP_LOGW(TAG, "Cached handles rejected (status=%d), waiting for service discovery", param->write.status);
+        this->stats_.handle_cache_misses++;
+        this->write_handle_ = 0;
+        this->reset_notification_state_();
+        break;
+      }
+      this->notify_registered_ = true;
+      this->stats_.handle_cache_hits++;
+      this->mark_handles_ready_("cached");
+      this->status_notifications_ready_();
+      break;
+    }
+    case ESP_GATTC_CFG_MTU_EVT:
+      if (param->cfg_mtu.conn_id != this->parent()->get_conn_id())
+        break;
+      if (param->cfg_mtu.status != ESP_GATT_OK) {
+        ESP_LOGW(TAG, "MTU exchange failed, status=%d", param->cfg_mtu.status);
+        break;
       }
+      this->granted_mtu_ = param->cfg_mtu.mtu;
+      ESP_LOGI(TAG, "MTU granted: %u (requested %u)", this->granted_mtu_, this->mtu_);
       break;
     case ESP_GATTC_DISCONNECT_EVT:
       ESP_LOGI(TAG, "BLE connection lost to Neewer RGB660 (reason: %d)", param->disconnect.reason);
       this->client_state_ = espbt::ClientState::IDLE;
       ESP_LOGD(TAG, "Client state reset to IDLE");
+      this->conn_profile_ = NeewerConnProfile::NONE;
+      this->granted_mtu_ = 0;
+      this->granted_interval_ = 0;
+      this->write_handle_ = 0;
+      this->handles_ready_ = false;
+      this->cache_validating_ = false;
+      this->decoder_.clear();
+      this->confirm_acked_us_ = 0;
       this->reset_notification_state_();
+      this->reset_write_queue_();
       this->status_notifications_lost_();
       break;
     case ESP_GATTC_WRITE_CHAR_EVT: {
-      if (param->write.status == 0) {
-        ESP_LOGD(TAG, "BLE write completed successfully (handle: 0x%04X)", param->write.handle);
-        break;
-      }
-
-      auto *chr = this->parent()->get_characteristic(this->service_uuid_, this->char_uuid_);
-      if (chr == nullptr) {
-        ESP_LOGW(TAG, "BLE write failed: characteristic not found");
+      // Without a slot, or on another handle, the event is not for one of our writes.
+      if (this->write_slot_count_ == 0 || param->write.handle != this->write_slot_(0).handle) {
+        ESP_LOGV(TAG, "Ignoring write completion for handle 0x%04X", param->write.handle);
         break;
       }
-      if (param->write.handle == chr->handle) {
-        ESP_LOGW(TAG, "BLE write failed: status=%d (handle: 0x%04X)", param->write.status, param->write.handle);
+      {
+        const uint8_t status = static_cast<uint8_t>(param->write.status);
+        this->trace_(NeewerTraceKind::ACK, &status, 1);
       }
+      this->complete_write_(param->write.status);
+      this->pump_queue_();
+      break;
+    }
+    case ESP_GATTC_CONGEST_EVT: {
+      if (param->congest.congested)
+        this->note_link_loss_("link congested");
       break;
     }
     case ESP_GATTC_NOTIFY_EVT: {
       if (param->notify.handle == this->notify_handle_) {
-        ESP_LOGV(TAG, "Notify received (%d bytes)", param->notify.value_len);
-        this->handle_status_notification_(param->notify.value, param->notify.value_len);
+        this->trace_(NeewerTraceKind::RX, param->notify.value, param->notify.value_len);
+        this->decoder_.feed(param->notify.value, param->notify.value_len);
+        NeewerPacket frame;
+        while (this->decoder_.next(&frame))
+          this->handle_status_frame_(frame);
       }
       break;
     }
@@ -140,72 +144,465 @@ void NeewerBLEOutput::gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_i
 };
 
 void NeewerBLEOutput::write_state(float state) {
-  ESP_LOGD(TAG, "Sending BLE command to light (state: %.2f)", state);
-  ESP_LOGD(TAG, "Current BLE state: %s", this->client_state_ == espbt::ClientState::ESTABLISHED ? "CONNECTED" : "DISCONNECTED");
-  
+  // Raw float writes carry whatever frame was prepared last; treat it as colour data.
+  this->queue_msg_(NeewerCommandClass::HSI);
+};
+
+void NeewerBLEOutput::loop() {
+  this->pump_queue_();
+  this->update_conn_profile_();
+  if (this->stats_interval_ms_ != 0 && millis() - this->last_stats_ms_ >= this->stats_interval_ms_) {
+    this->last_stats_ms_ = millis();
+    this->log_stats_();
+  }
+}
+
+void NeewerBLEOutput::log_stats_() {
+  const auto &stats = this->stats_;
+  const uint32_t calls = stats.light_calls;
+  const auto &rx = this->decoder_.get_stats();
+  ESP_LOGI(TAG,
+           "[nwstats] {\"light\":%u,\"calls\":%u,\"frames\":%u,\"frames_per_call\":%.2f,\"bytes\":%u,"
+           "\"power\":%u,\"hsi\":%u,\"cct\":%u,\"fx\":%u,\"power_status\":%u,\"channel_status\":%u,"
+           "\"suppressed\":%u,\"coalesced\":%u,\"encode_us_avg\":%.1f,\"rx_frames\":%u,\"rx_bad_checksum\":%u,"
+           "\"rx_bad_length\":%u,\"rx_skipped\":%u,\"rx_overflow\":%u,\"rx_unknown\":%u,\"resyncs\":%u,"
+           "\"resync_frames\":%u,\"consistent_ms_last\":%u,\"ready_ms_last\":%u,\"handle_cache_hits\":%u,"
+           "\"handle_cache_misses\":%u,\"user_latency_ms_avg\":%.1f,\"user_latency_ms_max\":%.1f,"
+           "\"user_behind_background\":%u,\"channel\":%u,\"channel_changes\":%u}",
+           this->light_id_, calls, stats.frames_sent, calls == 0 ? 0.0f : float(stats.frames_sent) / calls,
+           stats.bytes_sent, stats.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::POWER)],
+           stats.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::HSI)],
+           stats.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::CCT)],
+           stats.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::FX)],
+           stats.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::POWER_STATUS)],
+           stats.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::CHANNEL_STATUS)], this->suppressed_writes_,
+           this->command_queue_.get_coalesced_count(),
+           stats.encodes == 0 ? 0.0f : float(stats.encode_us) / stats.encodes, rx.frames, rx.bad_checksum,
+           rx.bad_length, rx.skipped_bytes, rx.overflows, rx.unknown_tags, stats.resyncs, stats.resync_frames,
+           stats.consistent_ms_last, stats.ready_ms_last, stats.handle_cache_hits, stats.handle_cache_misses,
+           stats.user_frames == 0 ? 0.0f : float(stats.user_latency_us_total) / stats.user_frames / 1000.0f,
+           stats.user_latency_us_max / 1000.0f, stats.user_behind_background, stats.channel, stats.channel_changes);
+}
+
+void NeewerBLEOutput::set_packet_trace(bool enabled) {
+  this->packet_trace_ = enabled;
+  if (enabled && this->parent_ != nullptr)
+    NeewerPacketTrace::register_light(this->light_id_, this->parent_->address_str());
+}
+
+// Queue the prepared msg_ under its command class. Only the newest frame per class
+// survives, and frames only go out once the previous write has been acknowledged.
+bool NeewerBLEOutput::queue_msg_(NeewerCommandClass command_class, NeewerPriority priority) {
   if (this->client_state_ != espbt::ClientState::ESTABLISHED) {
+    if (this->pooled_) {
+      // The pool connects the light; the reconnect resync sends the desired state.
+      this->link_wanted_ = true;
+      ESP_LOGV(TAG, "Not connected, waiting for a pool slot");
+      return false;
+    }
     ESP_LOGW(TAG, "Not connected to BLE client. Command aborted.");
+    return false;
+  }
+  if (this->msg_.empty()) {
+    ESP_LOGW(TAG, "Message empty - cannot send to light");
+    return false;
+  }
+
+  if (is_mode_class(command_class)) {
+    const NeewerPacket &held = this->mode_frame_pending_() ? this->queued_mode_frame_ : this->acked_mode_frame_;
+    if (held == this->msg_) {
+      this->suppressed_writes_++;
+      ESP_LOGV(TAG, "Suppressed byte-identical frame (%u suppressed so far)", this->suppressed_writes_);
+      return false;
+    }
+    this->queued_mode_frame_ = this->msg_;
+    this->mode_frame_class_ = command_class;
+  } else if (command_class == NeewerCommandClass::POWER) {
+    // The light may come out of standby in a different state; always resend the mode frame.
+    this->clear_mode_frames_();
+  }
+
+  if (priority != NeewerPriority::BACKGROUND) {
+    this->last_foreground_ms_ = millis();
+    // A write can't be recalled; count the times a status query was in the way.
+    if (priority <= NeewerPriority::USER && this->write_in_flight_() &&
+        this->write_slot_(this->write_slot_count_ - 1).priority == NeewerPriority::BACKGROUND)
+      this->stats_.user_behind_background++;
+  }
+  const uint32_t origin_us = this->frame_origin_us_ != 0 ? this->frame_origin_us_ : micros();
+  this->last_queued_sequence_ = this->command_queue_.push(command_class, priority, this->msg_, origin_us);
+  this->last_activity_ms_ = millis();
+  if (this->conn_profile_ == NeewerConnProfile::IDLE)
+    this->request_conn_profile_(NeewerConnProfile::ACTIVE);
+  this->pump_queue_();
+  return true;
+}
+
+void NeewerBLEOutput::pump_queue_() {
+  const uint32_t now = millis();
+  for (uint8_t i = 0; i < this->write_slot_count_; i++) {
+    NeewerWriteSlot &slot = this->write_slot_(i);
+    if (slot.abandoned || now - slot.sent_ms < WRITE_ACK_TIMEOUT_MS)
+      continue;
+    // Give up on it, but keep the slot so its late event isn't credited to a later write.
+    ESP_LOGW(TAG, "BLE write %u not completed after %ums, sending next frame", slot.sequence, WRITE_ACK_TIMEOUT_MS);
+    slot.abandoned = true;
+    this->write_lost_(slot, "write ack timeout");
+  }
+  if (this->write_slot_count_ == WRITE_SLOT_COUNT) {
+    if (!this->write_slot_(0).abandoned)
+      return;
+    // Its event is not coming any more; make room.
+    this->write_slot_head_ = (this->write_slot_head_ + 1) % WRITE_SLOT_COUNT;
+    this->write_slot_count_--;
+  }
+  if (this->write_slot_count_ != 0) {
+    // An acknowledged write holds the link until its response; a write without
+    // response only paces the next one.
+    const NeewerWriteSlot &newest = this->write_slot_(this->write_slot_count_ - 1);
+    if (!newest.abandoned && (newest.write_type == ESP_GATT_WRITE_TYPE_RSP ||
+                              now - newest.sent_ms < NO_RSP_WRITE_INTERVAL_MS))
+      return;
+  }
+  // Cached handles are only written to once enabling notifications has proven them.
+  if (this->client_state_ != espbt::ClientState::ESTABLISHED || !this->handles_ready_)
     return;
+
+  NeewerPacket packet;
+  NeewerCommandClass command_class;
+  uint32_t sequence;
+  NeewerPriority priority;
+  uint32_t origin_us;
+  const bool quiet = millis() - this->last_foreground_ms_ >= BACKGROUND_QUIET_MS;
+  while (this->command_queue_.pop(&packet, &command_class, &sequence, &priority, &origin_us, quiet)) {
+    ESP_LOGV(TAG, "Dequeued frame class %u (%u bytes)", static_cast<unsigned>(command_class), packet.size());
+    const esp_gatt_write_type_t write_type = this->write_type_for_(command_class);
+    if (this->transmit_(packet, write_type)) {
+      NeewerWriteSlot slot;
+      slot.sequence = sequence;
+      slot.write_type = write_type;
+      slot.handle = this->write_handle_;
+      slot.command_class = command_class;
+      slot.priority = priority;
+      slot.origin_us = origin_us;
+      slot.sent_ms = millis();
+      slot.packet = packet;
+      this->push_write_slot_(slot);
+      if (priority <= NeewerPriority::USER)
+        this->record_latency_(NeewerLatencyStage::WRITE, origin_us);
+      this->stats_.frames_sent++;
+      this->stats_.bytes_sent += packet.size();
+      this->stats_.frames_by_class[static_cast<uint8_t>(command_class)]++;
+      this->frame_sent_(command_class);
+      return;
+    }
+    if (is_mode_class(command_class))
+      this->clear_mode_frames_();
   }
+}
 
+bool NeewerBLEOutput::resolve_write_handle_() {
+  if (this->write_handle_ != 0)
+    return true;
   auto *chr = this->parent()->get_characteristic(this->service_uuid_, this->char_uuid_);
   if (chr == nullptr) {
-    ESP_LOGW(TAG, "[%s] BLE characteristic not found. Command aborted.",
-             this->char_uuid_.to_string().c_str());
+    ESP_LOGW(TAG, "[%s] BLE characteristic not found.", this->char_uuid_.to_string().c_str());
+    return false;
+  }
+  this->write_handle_ = chr->handle;
+  ESP_LOGD(TAG, "Resolved write handle 0x%04X", this->write_handle_);
+  return true;
+}
+
+// Plain handle write; the characteristic lookup happened once after discovery.
+bool NeewerBLEOutput::transmit_(NeewerPacket &packet, esp_gatt_write_type_t write_type) {
+  if (!this->resolve_write_handle_()) {
+    ESP_LOGW(TAG, "No write handle yet. Command aborted.");
+    return false;
+  }
+
+  ESP_LOGD(TAG, "Transmitting %i bytes to Neewer RGB660...", packet.size());
+  this->trace_(NeewerTraceKind::TX, packet.data(), packet.size());
+  esp_err_t status = esp_ble_gattc_write_char(this->parent()->get_gattc_if(), this->parent()->get_conn_id(),
+                                              this->write_handle_, packet.size(), packet.data(), write_type,
+                                              ESP_GATT_AUTH_REQ_NONE);
+  if (status != ESP_OK) {
+    ESP_LOGW(TAG, "BLE transmission failed, status=%d", status);
+    this->stats_.write_failures++;
+    this->note_link_loss_("write rejected");
+    return false;
+  }
+  return true;
+}
+
+// Colour, white and scene frames may go out as write-without-response; power and
+// status requests always wait for an acknowledgement.
+esp_gatt_write_type_t NeewerBLEOutput::write_type_for_(NeewerCommandClass command_class) {
+  if (this->require_response_)
+    return ESP_GATT_WRITE_TYPE_RSP;
+  if (!is_mode_class(command_class))
+    return ESP_GATT_WRITE_TYPE_RSP;
+
+  if (this->fast_path_degraded_) {
+    if (millis() - this->fast_path_degraded_ms_ < FAST_PATH_RETRY_MS)
+      return ESP_GATT_WRITE_TYPE_RSP;
+    ESP_LOGI(TAG, "Retrying write-without-response fast path");
+    this->fast_path_degraded_ = false;
+    this->recent_losses_ = 0;
+    this->no_rsp_latency_avg_ms_ = 0;
+    this->no_rsp_latency_base_ms_ = 0;
+  }
+  return ESP_GATT_WRITE_TYPE_NO_RSP;
+}
+
+void NeewerBLEOutput::note_link_loss_(const char *reason) {
+  const uint32_t now = millis();
+  if (now - this->loss_window_start_ms_ > FAST_PATH_LOSS_WINDOW_MS) {
+    this->loss_window_start_ms_ = now;
+    this->recent_losses_ = 0;
+  }
+  this->recent_losses_++;
+  ESP_LOGD(TAG, "Link loss detected (%s), %u in window", reason, this->recent_losses_);
+
+  if (this->require_response_ || this->fast_path_degraded_ || this->recent_losses_ < FAST_PATH_LOSS_THRESHOLD)
     return;
+  ESP_LOGW(TAG,
+           "Repeated losses (ack avg %ums, unacknowledged write avg %ums vs %ums, confirm avg %ums), falling back "
+           "to acknowledged writes for %us",
+           this->ack_latency_avg_ms_, this->no_rsp_latency_avg_ms_, this->no_rsp_latency_base_ms_,
+           this->confirm_latency_avg_ms_, FAST_PATH_RETRY_MS / 1000);
+  this->fast_path_degraded_ = true;
+  this->fast_path_degraded_ms_ = now;
+}
+
+bool NeewerBLEOutput::write_in_flight_() const {
+  for (uint8_t i = 0; i < this->write_slot_count_; i++) {
+    if (!this->write_slot_(i).abandoned)
+      return true;
   }
+  return false;
+}
 
-  // this->msg_ must be prepared prior to running this function
-  ESP_LOGD(TAG, "Message prepared: %i bytes ready for transmission", this->msg_len_);
-  if(!this->msg_ && !this->msg_len_) {
-    ESP_LOGW(TAG, "Message empty - cannot send to light");
-  } else if(chr != nullptr) {
-    ESP_LOGD(TAG, "Transmitting %i bytes to Neewer RGB660...", this->msg_len_);
-    for (int i = 0; i < this->msg_len_; i++) {
-      ESP_LOGV(TAG, "   Byte %i: 0x%02X", i, this->msg_[i]);
-    }
-    chr->write_value(this->msg_, this->msg_len_, ESP_GATT_WRITE_TYPE_RSP);
-    ESP_LOGD(TAG, "Command transmitted to light");
-  } else {
-    ESP_LOGW(TAG, "BLE transmission failed: characteristic unavailable");
+void NeewerBLEOutput::push_write_slot_(const NeewerWriteSlot &slot) {
+  this->write_slot_count_++;
+  this->write_slot_(this->write_slot_count_ - 1) = slot;
+}
+
+// The oldest slot's write completed. Writes without response go through the same
+// path as acknowledged ones: they feed the latency trend and write_acked_.
+void NeewerBLEOutput::complete_write_(esp_gatt_status_t status) {
+  const NeewerWriteSlot slot = this->write_slot_(0);
+  this->write_slot_head_ = (this->write_slot_head_ + 1) % WRITE_SLOT_COUNT;
+  this->write_slot_count_--;
+  if (slot.abandoned) {
+    ESP_LOGD(TAG, "Late completion of write %u, already given up on", slot.sequence);
+    return;
+  }
+  if (status != ESP_GATT_OK) {
+    ESP_LOGW(TAG, "BLE write failed: status=%d (handle: 0x%04X)", status, slot.handle);
+    this->write_lost_(slot, "write failed");
+    return;
   }
-};
 
-// Prepare the msg_ byte array and append checksum
-// Algorithm borrowed from https://github.com/keefo/NeewerLite (MIT Licensed)
-void NeewerBLEOutput::build_msg_with_checksum(){
-  this->msg_clear();
+  const uint32_t latency = millis() - slot.sent_ms;
+  this->note_write_latency_(slot.write_type, latency);
+  this->acked_sequence_ = slot.sequence;
+  this->acked_us_ = micros();
+  if (slot.priority <= NeewerPriority::USER) {
+    const uint32_t user_latency = this->acked_us_ - slot.origin_us;
+    this->latency_[static_cast<uint8_t>(NeewerLatencyStage::ACK)].record(user_latency);
+    this->confirm_acked_us_ = this->acked_us_;
+    this->stats_.user_frames++;
+    this->stats_.user_latency_us_total += user_latency;
+    this->stats_.user_latency_us_max = std::max(this->stats_.user_latency_us_max, user_latency);
+  }
+  ESP_LOGD(TAG, "BLE write %u completed successfully (handle: 0x%04X, %ums)", slot.sequence, slot.handle, latency);
+  if (is_mode_class(slot.command_class))
+    this->acked_mode_frame_ = slot.packet;
+  this->write_acked_(slot.command_class, slot.packet);
+}
 
-  int checksum = 0;
-  for (int i = 0; i < this->orig_msg_len_; i++) {
-    this->msg_[i] = this->orig_msg_[i] < 0 ? (uint8_t)(this->orig_msg_[i] + 0x100) : (uint8_t) this->orig_msg_[i];
-    checksum = checksum + this->msg_[i];
+void NeewerBLEOutput::write_lost_(const NeewerWriteSlot &slot, const char *reason) {
+  this->stats_.write_failures++;
+  this->note_link_loss_(reason);
+  if (is_mode_class(slot.command_class))
+    this->clear_mode_frames_();
+  this->write_failed_(slot.command_class);
+}
+
+// Losses are the late sign of a struggling fast path. Completion times that climb
+// well above their own long-run level come first and count the same way.
+void NeewerBLEOutput::note_write_latency_(esp_gatt_write_type_t write_type, uint32_t latency_ms) {
+  if (write_type == ESP_GATT_WRITE_TYPE_RSP) {
+    // Exponential moving average, weight 1/4 for the newest sample.
+    this->ack_latency_avg_ms_ = (this->ack_latency_avg_ms_ * 3 + latency_ms) / 4;
+    return;
   }
-  this->msg_[this->orig_msg_len_] = (uint8_t) (checksum & 0xFF);
-  this->msg_len_ = this->orig_msg_len_ + 1;
-  ESP_LOGD(TAG, "Message finalized: %i bytes + checksum (0x%02X)", this->orig_msg_len_, checksum & 0xFF);
-};
+  if (this->no_rsp_latency_base_ms_ == 0) {
+    this->no_rsp_latency_avg_ms_ = latency_ms;
+    this->no_rsp_latency_base_ms_ = latency_ms;
+    return;
+  }
+  this->no_rsp_latency_avg_ms_ = (this->no_rsp_latency_avg_ms_ * 3 + latency_ms) / 4;
+  this->no_rsp_latency_base_ms_ = (this->no_rsp_latency_base_ms_ * 15 + latency_ms) / 16;
+  if (this->no_rsp_latency_avg_ms_ > this->no_rsp_latency_base_ms_ * 2 + FAST_PATH_LATENCY_MARGIN_MS)
+    this->note_link_loss_("write latency rising");
+}
+
+// Ask the light for the profile's connection parameters. The request is
+// asynchronous; what was granted arrives as ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT.
+void NeewerBLEOutput::request_conn_profile_(NeewerConnProfile profile) {
+  const NeewerConnParams &params =
+      profile == NeewerConnProfile::IDLE ? this->idle_conn_params_ : this->active_conn_params_;
+  if (params.max_interval == 0 || this->conn_profile_ == profile)
+    return;
 
-void NeewerBLEOutput::msg_clear() {
-  for (int i = 0; i < MSG_MAX_SIZE; i++) {
-    this->msg_[i] = 0;
+  esp_ble_conn_update_params_t update{};
+  memcpy(update.bda, this->parent()->get_remote_bda(), sizeof(update.bda));
+  update.min_int = params.min_interval;
+  update.max_int = params.max_interval;
+  update.latency = params.latency;
+  update.timeout = params.timeout;
+  esp_err_t status = esp_ble_gap_update_conn_params(&update);
+  if (status != ESP_OK) {
+    ESP_LOGW(TAG, "Connection parameter update failed, status=%d", status);
+    return;
   }
-  this->msg_len_ = 0;
-};
+  ESP_LOGD(TAG, "Requested %s connection profile: %.2f-%.2fms, latency %u, timeout %ums",
+           profile == NeewerConnProfile::IDLE ? "idle" : "active", params.min_interval * 1.25f,
+           params.max_interval * 1.25f, params.latency, params.timeout * 10u);
+  this->conn_profile_ = profile;
+}
+
+void NeewerBLEOutput::update_conn_profile_() {
+  if (this->conn_profile_ != NeewerConnProfile::ACTIVE || this->client_state_ != espbt::ClientState::ESTABLISHED)
+    return;
+  if (!this->command_queue_.empty() || this->write_in_flight_())
+    return;
+  if (millis() - this->last_activity_ms_ >= this->idle_after_ms_)
+    this->request_conn_profile_(NeewerConnProfile::IDLE);
+}
 
-void NeewerBLEOutput::orig_msg_clear() {
-  for (int i = 0; i < MSG_MAX_SIZE; i++) {
-    this->orig_msg_[i] = 0;
+void NeewerBLEOutput::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+  if (event != ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT)
+    return;
+  // GAP events are shared by every connection; only look at our own.
+  const auto &update = param->update_conn_params;
+  if (memcmp(update.bda, this->parent()->get_remote_bda(), sizeof(update.bda)) != 0)
+    return;
+  if (update.status != ESP_GATT_OK) {
+    ESP_LOGW(TAG, "Light rejected connection parameters, status=%d", update.status);
+    return;
   }
-  this->orig_msg_len_ = 0;
-};
+  this->granted_interval_ = update.conn_int;
+  this->granted_latency_ = update.latency;
+  this->granted_timeout_ = update.timeout;
+  ESP_LOGI(TAG, "Connection parameters granted: interval %.2fms, latency %u, timeout %ums",
+           update.conn_int * 1.25f, update.latency, update.timeout * 10u);
+}
 
-NeewerBLEOutput::NeewerBLEOutput() {
-  msg_ = (uint8_t*) malloc (MSG_MAX_SIZE);
-  this->msg_clear();
-  orig_msg_ = (uint8_t*) malloc (MSG_MAX_SIZE);
-  this->orig_msg_clear();
-};
+void NeewerBLEOutput::note_confirmation_latency_(uint32_t latency_ms) {
+  this->confirm_latency_avg_ms_ = (this->confirm_latency_avg_ms_ * 3 + latency_ms) / 4;
+}
+
+void NeewerBLEOutput::reset_write_queue_() {
+  this->command_queue_.clear();
+  this->clear_mode_frames_();
+  this->write_slot_head_ = 0;
+  this->write_slot_count_ = 0;
+}
+
+bool NeewerBLEOutput::mode_frame_pending_() const {
+  for (uint8_t i = 0; i < this->write_slot_count_; i++) {
+    const NeewerWriteSlot &slot = this->write_slot_(i);
+    if (!slot.abandoned && is_mode_class(slot.command_class))
+      return true;
+  }
+  return this->is_command_pending_(NeewerCommandClass::HSI) || this->is_command_pending_(NeewerCommandClass::CCT) ||
+         this->is_command_pending_(NeewerCommandClass::FX);
+}
+
+uint32_t NeewerCommandQueue::push(NeewerCommandClass command_class, NeewerPriority priority,
+                                  const NeewerPacket &packet, uint32_t origin_us) {
+  // A colour, white or scene frame fully defines the light output, so it supersedes
+  // any pending frame of the other modes. A power frame supersedes them too: power
+  // goes out first, so a mode frame queued before it would otherwise land after it.
+  // Whoever queues power together with a mode frame queues the mode frame second.
+  if (is_mode_class(command_class) || command_class == NeewerCommandClass::POWER) {
+    this->drop_(NeewerCommandClass::HSI);
+    this->drop_(NeewerCommandClass::CCT);
+    this->drop_(NeewerCommandClass::FX);
+  }
+  this->drop_(command_class);
+
+  auto &slot = this->slots_[static_cast<uint8_t>(command_class)];
+  slot.packet = packet;
+  slot.sequence = this->next_sequence_++;
+  slot.priority = priority;
+  slot.origin_us = origin_us;
+  slot.pending = true;
+  return slot.sequence;
+}
+
+// Most urgent priority first, oldest first within a priority.
+bool NeewerCommandQueue::pop(NeewerPacket *packet, NeewerCommandClass *command_class, uint32_t *sequence,
+                             NeewerPriority *priority, uint32_t *origin_us, bool allow_background) {
+  Slot *next = nullptr;
+  uint8_t next_index = 0;
+  for (uint8_t i = 0; i < COMMAND_CLASS_COUNT; i++) {
+    auto &slot = this->slots_[i];
+    if (!slot.pending || (slot.priority == NeewerPriority::BACKGROUND && !allow_background))
+      continue;
+    if (next == nullptr || slot.priority < next->priority ||
+        (slot.priority == next->priority && slot.sequence < next->sequence)) {
+      next = &slot;
+      next_index = i;
+    }
+  }
+  if (next == nullptr)
+    return false;
+
+  *packet = next->packet;
+  *command_class = static_cast<NeewerCommandClass>(next_index);
+  *sequence = next->sequence;
+  *priority = next->priority;
+  *origin_us = next->origin_us;
+  next->pending = false;
+  return true;
+}
+
+bool NeewerCommandQueue::is_pending(NeewerCommandClass command_class) const {
+  return this->slots_[static_cast<uint8_t>(command_class)].pending;
+}
+
+bool NeewerCommandQueue::empty() const {
+  for (const auto &slot : this->slots_) {
+    if (slot.pending)
+      return false;
+  }
+  return true;
+}
+
+bool NeewerCommandQueue::has_foreground() const {
+  for (const auto &slot : this->slots_) {
+    if (slot.pending && slot.priority != NeewerPriority::BACKGROUND)
+      return true;
+  }
+  return false;
+}
+
+void NeewerCommandQueue::clear() {
+  for (auto &slot : this->slots_)
+    slot.pending = false;
+}
+
+void NeewerCommandQueue::drop_(NeewerCommandClass command_class) {
+  auto &slot = this->slots_[static_cast<uint8_t>(command_class)];
+  if (!slot.pending)
+    return;
+  slot.pending = false;
+  this->coalesced_count_++;
+}
 
 bool NeewerBLEOutput::register_for_notifications_(esp_gatt_if_t gattc_if) {
   if (this->notify_registered_)
@@ -223,28 +620,110 @@ bool NeewerBLEOutput::register_for_notifications_(esp_gatt_if_t gattc_if) {
     return false;
   }
 
-  esp_err_t reg_status = esp_ble_gattc_register_for_notify(gattc_if, this->parent()->get_remote_bda(), chr->handle);
+  this->notify_handle_ = chr->handle;
+  this->notify_cccd_handle_ = descr->handle;
+  if (!this->enable_notifications_(gattc_if))
+    return false;
+  this->notify_registered_ = true;
+  ESP_LOGD(TAG, "Registered for status notifications (handle: 0x%04X)", this->notify_handle_);
+  return true;
+}
+
+bool NeewerBLEOutput::enable_notifications_(esp_gatt_if_t gattc_if) {
+  esp_err_t reg_status =
+      esp_ble_gattc_register_for_notify(gattc_if, this->parent()->get_remote_bda(), this->notify_handle_);
   if (reg_status != ESP_OK) {
     ESP_LOGW(TAG, "esp_ble_gattc_register_for_notify failed, status=%d", reg_status);
     return false;
   }
 
   uint8_t notify_en[2] = {0x01, 0x00};
-  esp_err_t descr_status = esp_ble_gattc_write_char_descr(gattc_if, this->parent()->get_conn_id(), descr->handle,
-                                                          sizeof(notify_en), notify_en, ESP_GATT_WRITE_TYPE_RSP,
-                                                          ESP_GATT_AUTH_REQ_NONE);
+  esp_err_t descr_status = esp_ble_gattc_write_char_descr(gattc_if, this->parent()->get_conn_id(),
+                                                          this->notify_cccd_handle_, sizeof(notify_en), notify_en,
+                                                          ESP_GATT_WRITE_TYPE_RSP, ESP_GATT_AUTH_REQ_NONE);
   if (descr_status != ESP_OK) {
     ESP_LOGW(TAG, "Failed to enable notify descriptor, status=%d", descr_status);
     return false;
   }
-
-  this->notify_handle_ = chr->handle;
-  this->notify_cccd_handle_ = descr->handle;
-  this->notify_registered_ = true;
-  ESP_LOGD(TAG, "Registered for status notifications (handle: 0x%04X)", this->notify_handle_);
   return true;
 }
 
+void NeewerBLEOutput::mark_handles_ready_(const char *source) {
+  if (this->handles_ready_)
+    return;
+  this->handles_ready_ = true;
+  this->link_wanted_ = false;
+  this->stats_.ready_ms_last = millis() - this->connected_ms_;
+  ESP_LOGI(TAG, "Light controllable %ums after connecting (%s handles)", this->stats_.ready_ms_last, source);
+  this->connection_ready_();
+}
+
+// Handles are stored per light MAC. On a new connection they are tried straight
+// away, without waiting for ESPHome's service discovery: enabling notifications
+// on the cached CCCD handle either succeeds (handles are good, the light is
+// usable immediately) or fails, in which case discovery finishes the job.
+ESPPreferenceObject &NeewerBLEOutput::get_handle_cache_pref_() {
+  if (!this->handle_cache_pref_ready_) {
+    const uint32_t key = fnv1_hash(std::string("neewerlight_handles_") + this->parent()->address_str());
+    this->handle_cache_pref_ = global_preferences->make_preference<NeewerHandleCache>(key, true);
+    this->handle_cache_pref_ready_ = true;
+  }
+  return this->handle_cache_pref_;
+}
+
+void NeewerBLEOutput::try_cached_handles_(esp_gatt_if_t gattc_if) {
+  NeewerHandleCache cache{};
+  if (!this->get_handle_cache_pref_().load(&cache) || cache.write_handle == 0 || cache.notify_handle == 0 ||
+      cache.cccd_handle == 0)
+    return;
+
+  ESP_LOGD(TAG, "Trying cached handles: write 0x%04X, notify 0x%04X, CCCD 0x%04X", cache.write_handle,
+           cache.notify_handle, cache.cccd_handle);
+  this->write_handle_ = cache.write_handle;
+  this->notify_handle_ = cache.notify_handle;
+  this->notify_cccd_handle_ = cache.cccd_handle;
+  this->cache_validating_ = this->enable_notifications_(gattc_if);
+  if (!this->cache_validating_) {
+    this->write_handle_ = 0;
+    this->reset_notification_state_();
+  }
+}
+
+void NeewerBLEOutput::save_handle_cache_() {
+  NeewerHandleCache cache{};
+  cache.write_handle = this->write_handle_;
+  cache.notify_handle = this->notify_handle_;
+  cache.cccd_handle = this->notify_cccd_handle_;
+  NeewerHandleCache stored{};
+  if (this->get_handle_cache_pref_().load(&stored) && memcmp(&stored, &cache, sizeof(cache)) == 0)
+    return;
+  if (this->get_handle_cache_pref_().save(&cache))
+    ESP_LOGD(TAG, "Saved handle cache for %s", this->parent()->address_str());
+}
+
+void NeewerBLEOutput::check_cached_handles_() {
+  auto *chr = this->parent()->get_characteristic(this->service_uuid_, this->char_uuid_);
+  auto *notify_chr = this->parent()->get_characteristic(this->service_uuid_, this->notify_char_uuid_);
+  auto *descr = this->parent()->get_descriptor(this->service_uuid_, this->notify_char_uuid_, this->cccd_uuid_);
+  if (chr == nullptr || notify_chr == nullptr || descr == nullptr)
+    return;
+  if (chr->handle == this->write_handle_ && notify_chr->handle == this->notify_handle_ &&
+      descr->handle == this->notify_cccd_handle_)
+    return;
+  ESP_LOGW(TAG, "Discovered handles (write 0x%04X, notify 0x%04X, CCCD 0x%04X) differ from the cache; updating it",
+           chr->handle, notify_chr->handle, descr->handle);
+  this->write_handle_ = chr->handle;
+  if (notify_chr->handle != this->notify_handle_ || descr->handle != this->notify_cccd_handle_) {
+    // The cached CCCD accepted the write but isn't the status characteristic's;
+    // enable notifications where discovery says they are.
+    this->reset_notification_state_();
+    this->status_notifications_lost_();
+    if (this->register_for_notifications_(this->parent()->get_gattc_if()))
+      this->status_notifications_ready_();
+  }
+  this->save_handle_cache_();
+}
+
 void NeewerBLEOutput::reset_notification_state_() {
   this->notify_registered_ = false;
   this->notify_handle_ = 0;
@@ -253,456 +732,273 @@ void NeewerBLEOutput::reset_notification_state_() {
 
 void NeewerRGBCTLightOutput::dump_config() {
   ESP_LOGCONFIG(TAG, "Neewer RGBCT Light Output:");
+  ESP_LOGCONFIG(TAG, "  Model              : %s", this->model_name_());
   ESP_LOGCONFIG(TAG, "  MAC address        : %s", this->parent_->address_str());
   ESP_LOGCONFIG(TAG, "  Service UUID       : %s", this->service_uuid_.to_string().c_str());
   ESP_LOGCONFIG(TAG, "  Characteristic UUID: %s", this->char_uuid_.to_string().c_str());
-  ESP_LOGCONFIG(TAG, "  Require Response   : %s", this->require_response_ ? "True" : "False");
+  ESP_LOGCONFIG(TAG, "  Require Response   : %s", this->require_response_ ? "True" : "False (adaptive)");
+  if (this->active_conn_params_.max_interval != 0) {
+    ESP_LOGCONFIG(TAG, "  Active Interval    : %.2f-%.2fms", this->active_conn_params_.min_interval * 1.25f,
+                  this->active_conn_params_.max_interval * 1.25f);
+  }
+  if (this->idle_conn_params_.max_interval != 0) {
+    ESP_LOGCONFIG(TAG, "  Idle Interval      : %.2f-%.2fms after %ums", this->idle_conn_params_.min_interval * 1.25f,
+                  this->idle_conn_params_.max_interval * 1.25f, this->idle_after_ms_);
+  }
+  if (this->mtu_ != 0)
+    ESP_LOGCONFIG(TAG, "  MTU                : %u", this->mtu_);
+  ESP_LOGCONFIG(TAG, "  Status Verify Delay: %ums%s", this->verify_delay_ms_,
+                this->track_channel_ ? " (with channel)" : "");
   ESP_LOGCONFIG(TAG, "  Colour Temperatures: %.2f - %.2f", 
                 this->cold_white_temperature_, this->warm_white_temperature_);
   ESP_LOGCONFIG(TAG, "  Colour Interlock   : %s", this->color_interlock_ ? "On" : "Off");
   LOG_BINARY_OUTPUT(this);
 };
 
-bool NeewerRGBCTLightOutput::did_rgb_change(float red, float green, float blue) {
-  if (red != this->old_red_) return true;
-  if (green != this->old_green_) return true;
-  if (blue != this->old_blue_) return true;
-  return false;
-};
-
-bool NeewerRGBCTLightOutput::did_ctwb_change(float color_temperature, float white_brightness) {
-  if (color_temperature != this->old_color_temperature_) return true;
-  if (white_brightness != this->old_white_brightness_) return true;
-  return false;
-};
-
-bool NeewerRGBCTLightOutput::did_only_wb_change(float color_temperature, float white_brightness) {
-  if (color_temperature != this->old_color_temperature_) return false;
-  if (white_brightness != this->old_white_brightness_) return true;
-  return false;  // Neither changed.
-};
+// Mireds onto the 0 (cold) - 1 (warm) scale write_state receives.
+float NeewerRGBCTLightOutput::normalize_color_temperature(float mireds) const {
+  const float mired_span = this->warm_white_temperature_ - this->cold_white_temperature_;
+  if (mired_span <= 0.0f)
+    return 0.0f;
+  return clamp((mireds - this->cold_white_temperature_) / mired_span, 0.0f, 1.0f);
+}
 
 float NeewerRGBCTLightOutput::normalized_ct_to_kelvin_(float normalized_ct) const {
   const float normalized = clamp(normalized_ct, 0.0f, 1.0f);
   const float mired_span = this->warm_white_temperature_ - this->cold_white_temperature_;
   const float mired = this->cold_white_temperature_ + (normalized * mired_span);
-  if (mired <= 0.0f) {
-    return (this->kelvin_min_ + this->kelvin_max_) / 2.0f;
-  }
+  if (mired <= 0.0f)
+    return 0.0f;  // callers clamp into the model's range
   return 1000000.0f / mired;
 }
 
-void NeewerRGBCTLightOutput::prepare_ctwb_msg(float color_temperature, float white_brightness) {
-  ESP_LOGD(TAG, "Building CTWB message: CT(normalized)=%.3f brightness=%.1f%%", color_temperature,
-           white_brightness * 100);
-  
-  uint8_t wb = (uint8_t) (white_brightness * 100.0);
-  uint8_t ct_byte;
-  uint8_t gm_byte = 0;
-  bool include_gm = this->supports_gm_;
-
-  if (include_gm) {
-    const float converted_kelvin = this->normalized_ct_to_kelvin_(color_temperature);
-    const float clamped_kelvin = clamp(converted_kelvin, this->kelvin_min_, this->kelvin_max_);
-    const float span = this->kelvin_max_ - this->kelvin_min_;
-    const float normalized = span > 0.0f ? (clamped_kelvin - this->kelvin_min_) / span : 0.0f;
-    ct_byte = static_cast<uint8_t>(roundf(normalized * 60.0f) + 25.0f);
-    gm_byte = static_cast<uint8_t>(roundf(clamp(this->green_magenta_bias_ + 50.0f, 0.0f, 100.0f)));
-    ESP_LOGD(TAG, "Converted RGB62 CT normalized=%.3f -> kelvin=%.0fK -> byte=%u GM=%u (bias %.1f)",
-             color_temperature, clamped_kelvin, ct_byte, gm_byte, this->green_magenta_bias_);
-  } else {
-    ct_byte = (uint8_t) abs((color_temperature * 24.0f) - 56.0f);
-    ESP_LOGD(TAG, "Converted legacy CT normalized=%.3f -> byte=0x%02X", color_temperature, ct_byte);
-  }
-
-  this->orig_msg_clear();
-
-  // Prepare string for write_state.
-  this->orig_msg_[0] = this->command_prefix_;        // 0x78
-  this->orig_msg_[1] = this->ctwb_prefix_;           // 0x86
-  if (include_gm) {
-    this->orig_msg_[2] = 5;
-    this->orig_msg_[3] = wb;
-    this->orig_msg_[4] = ct_byte;
-    this->orig_msg_[5] = gm_byte;
-    this->orig_msg_[6] = 0x00;
-    this->orig_msg_[7] = 0x00;
-    this->orig_msg_len_ = 8;
-  } else {
-    this->orig_msg_[2] = 2;
-    this->orig_msg_[3] = wb;
-    this->orig_msg_[4] = ct_byte;
-    this->orig_msg_len_ = 5;
-  }
-
-  ESP_LOGD(TAG, "CT packet bytes (payload_len=%u): brr=%u ct_byte=0x%02X gm=%u", this->orig_msg_[2], wb, ct_byte,
-           gm_byte);
-  for (uint8_t i = 0; i < this->orig_msg_len_; i++) {
-    ESP_LOGV(TAG, "CT payload[%u] = 0x%02X", i, this->orig_msg_[i]);
-  }
-
-  NeewerBLEOutput::build_msg_with_checksum();
-  ESP_LOGD(TAG, "CT msg (len=%u inc checksum)", this->msg_len_);
-  for (uint8_t i = 0; i < this->msg_len_; i++) {
-    ESP_LOGV(TAG, "CT msg[%u] = 0x%02X", i, this->msg_[i]);
-  }
-};
-
-// For whatever reason, the RGB660 will only allow brightness alone if CT hasn't changed
-void NeewerRGBCTLightOutput::prepare_wb_msg(float white_brightness) {
-  uint8_t wb = (uint8_t) (white_brightness * 100.0);
-
-  this->orig_msg_clear();
-
-  // Prepare string for write_state.
-  this->orig_msg_[0] = this->command_prefix_;        // 0x78
-  this->orig_msg_[1] = this->ctwb_prefix_;           // 0x86
-  this->orig_msg_[2] = 1;                            // Byte Count = 2 for ctwb
-  this->orig_msg_[3] = wb;                           // brightness 0x00 - 0x64
-  this->orig_msg_len_ = 4;
-  
-  ESP_LOGD(TAG, "WB-only payload (len=%u): brr=%u", this->orig_msg_len_, wb);
-
-  NeewerBLEOutput::build_msg_with_checksum();
-};
-
-void NeewerRGBCTLightOutput::prepare_power_msg_(bool power_on) {
-  this->orig_msg_clear();
-
-  this->orig_msg_[0] = this->command_prefix_;
-  this->orig_msg_[1] = this->power_prefix_;
-  this->orig_msg_[2] = 0x01;
-  this->orig_msg_[3] = power_on ? 0x01 : 0x02;
-  this->orig_msg_len_ = 4;
-
-  NeewerBLEOutput::build_msg_with_checksum();
-};
-
-void NeewerRGBCTLightOutput::send_power_command_(bool power_on) {
+bool NeewerRGBCTLightOutput::send_power_command_(bool power_on) {
   ESP_LOGI(TAG, "-> POWER %s: Sending BLE power command", power_on ? "ON" : "OFF");
   this->prepare_power_msg_(power_on);
-  NeewerBLEOutput::write_state(power_on ? 1.0f : 0.0f);
+  const bool queued = this->queue_msg_(NeewerCommandClass::POWER);
   this->light_on_ = power_on;
+  return queued;
 };
 
+// Status queries use the classic short frame on every model.
 void NeewerRGBCTLightOutput::prepare_status_msg_(uint8_t request_tag) {
-  this->orig_msg_clear();
-
-  this->orig_msg_[0] = this->command_prefix_;
-  this->orig_msg_[1] = request_tag;
-  this->orig_msg_[2] = 0x00;
-  this->orig_msg_len_ = 3;
-
-  NeewerBLEOutput::build_msg_with_checksum();
+  this->msg_.begin(request_tag);
+  this->msg_.finish();
 }
 
-void NeewerRGBCTLightOutput::prepare_rgb_msg(float red, float green, float blue) {
-  ESP_LOGD(TAG, "Building RGB message: R=%.2f G=%.2f B=%.2f", red, green, blue);
-  
-  int hue;
-  uint8_t saturation;
-  uint8_t brightness;
-
-  // Surprise, the "RGB" light isn't actually RGB!
-  this->rgb_to_hsb(red, green, blue, &hue, &saturation, &brightness);
-  this->last_hue_degrees_ = static_cast<uint16_t>(clamp(hue, 0, 360));
-  this->last_saturation_percent_ = saturation;
-  this->last_rgb_brightness_fraction_ = brightness / 100.0f;
-  
-  ESP_LOGD(TAG, "Converted to HSB: H=%d° S=%d%% B=%d%%", hue, saturation, brightness);
-
-  this->orig_msg_clear();
-
-  // Prepare string for write_state.
-  this->orig_msg_[0] = this->command_prefix_;        // 0x78
-  this->orig_msg_[1] = this->rgb_prefix_;            // 0x86
-  this->orig_msg_[2] = 4;                            // Byte Count = 4 for RGB
-  this->orig_msg_[3] = (int) (hue & 0xFF);           // hue int, split across two 8 bit ints
-  this->orig_msg_[4] = (int) ((hue & 0xFF00) >> 8);  // hue Shift 8 bits over
-  this->orig_msg_[5] = saturation;                   // saturation 0x00 - 0x64
-  this->orig_msg_[6] = brightness;                   // brightness 0x00 - 0x64
-  this->orig_msg_len_ = 7;
-  
-  ESP_LOGD(TAG, "RGB packet bytes (len=%u): hue_lsb=0x%02X hue_msb=0x%02X sat=%u brr=%u", this->orig_msg_len_,
-           this->orig_msg_[3], this->orig_msg_[4], saturation, brightness);
+// Every transition tick lands here. The newest target is stored, and frames are
+// emitted at most max_frame_rate times per second while a transition runs; loop()
+// flushes whatever is left so the final target always reaches the light.
+void NeewerRGBCTLightOutput::write_state(light_ns::LightState *state) {
+  auto &target = this->pending_target_;
+  state->current_values_as_rgbct(&target.red, &target.green, &target.blue, &target.color_temperature,
+                                 &target.white_brightness);
+  target.on = state->current_values.is_on();
+  this->frame_pending_ = true;
+  this->pending_call_us_ = micros();
+  this->stats_.light_calls++;
+
+  if (state->is_transformer_active() && millis() - this->last_frame_ms_ < this->min_frame_interval_ms_) {
+    ESP_LOGV(TAG, "Transition frame deferred by frame rate limit");
+    return;
+  }
+  this->emit_pending_frame_();
+}
 
-  NeewerBLEOutput::build_msg_with_checksum();
-};
+void NeewerRGBCTLightOutput::emit_pending_frame_() {
+  this->frame_pending_ = false;
+  this->last_frame_ms_ = millis();
 
-// Algorithm cobbled together from various corners of the internet. Works great!
-void NeewerRGBCTLightOutput::rgb_to_hsb(float red, float green, float blue,
-                                        int *hue, uint8_t *saturation, uint8_t *brightness) {
-  float max_value = 0.0;
-  float min_value = 0.0;
-  float diff_value = 0.0;
+  NeewerLightTarget target = this->pending_target_;
+  const NeewerCommandClass frame_class = this->encode_target(&target);
+  this->frame_origin_us_ = this->pending_call_us_;
+  this->apply_target(target, this->msg_, frame_class);
+  this->frame_origin_us_ = 0;
+}
 
-  ESP_LOGD(TAG, "Converting RGB to HSB: R=%.3f G=%.3f B=%.3f", red, green, blue);
-  
-  // Input validation
-  if (red < 0.0 || red > 1.0 || green < 0.0 || green > 1.0 || blue < 0.0 || blue > 1.0) {
-    ESP_LOGW(TAG, "RGB values out of range [0.0-1.0]: R=%.3f G=%.3f B=%.3f", red, green, blue);
+// Snap a target onto the light's resolution and encode its mode frame into msg_.
+// Returns the frame's command class; an off target has no mode frame.
+NeewerCommandClass NeewerRGBCTLightOutput::encode_target(NeewerLightTarget *target) {
+  const uint32_t encode_start = micros();
+  const NeewerCommandClass frame_class = this->encode_frame(target, &this->msg_);
+  if (target->on) {
+    this->stats_.encode_us += micros() - encode_start;
+    this->stats_.encodes++;
   }
+  return frame_class;
+}
 
-  // Determine maximum
-  max_value = red < green ? green : red;
-  max_value = max_value < blue ? blue : max_value;
+NeewerCommandClass NeewerRGBCTLightOutput::encode_frame(NeewerLightTarget *target, NeewerPacket *packet) const {
+  this->snap_to_device_resolution_(target);
+  const float red = target->red;
+  const float green = target->green;
+  const float blue = target->blue;
+  const float color_temperature = target->color_temperature;
+  const float white_brightness = target->white_brightness;
 
-  // Determine minimum
-  min_value = red < green ? red : green;
-  min_value = min_value < blue ? min_value : blue;
+  ESP_LOGD(TAG, "Light state update: RGB(%.2f,%.2f,%.2f) CT=%.3f WB=%.1f%%",
+           red, green, blue, color_temperature, white_brightness * 100);
 
-  // Determine difference
-  diff_value = max_value - min_value;
-  
-  ESP_LOGV(TAG, "RGB analysis: max=%.3f min=%.3f diff=%.3f", max_value, min_value, diff_value);
+  if (!target->on)
+    return NeewerCommandClass::POWER;
 
-  // Calculate value (brightness)
-  *brightness = (uint8_t) (max_value * 100);
-  ESP_LOGV(TAG, "Brightness calculation: %.3f * 100 = %d", max_value, *brightness);
+  const bool rgb_is_zero = red == 0.0f && green == 0.0f && blue == 0.0f;
+  const bool wb_is_zero = white_brightness == 0.0f;
 
-  // Calculate saturation
-  if (max_value == 0) {
-    *saturation = 0;
-    ESP_LOGV(TAG, "Saturation: 0 (grayscale - max_value is 0)");
-  } else {
-    float sat_calc = (diff_value / max_value) * 100;
-    *saturation = (uint8_t) sat_calc;
-    ESP_LOGV(TAG, "Saturation calculation: (%.3f / %.3f) * 100 = %.1f -> %d", diff_value, max_value, sat_calc, *saturation);
-  }
+  ESP_LOGD(TAG, "Mode analysis: RGB_zero=%s, WB_zero=%s", rgb_is_zero ? "YES" : "NO", wb_is_zero ? "YES" : "NO");
 
-  // Calculate hue
-  if (diff_value == 0) {
-    *hue = 0;
-    ESP_LOGV(TAG, "Hue: 0 (achromatic - no color difference)");
-  } else {
-    float hue_calc;
-    const char* dominant_color;
-    
-    if (max_value == red) {
-      hue_calc = 60 * ((float) remainder(((green - blue) / diff_value), 6.0));
-      dominant_color = "red";
-    } else if (max_value == green) {
-      hue_calc = 60 * (((blue - red) / diff_value) + 2.0);
-      dominant_color = "green";
-    } else {
-      hue_calc = 60 * (((red - green) / diff_value) + 4.0);
-      dominant_color = "blue";
-    }
-    
-    *hue = (int) hue_calc;
-    ESP_LOGV(TAG, "Hue calculation (dominant: %s): %.1f -> %d", dominant_color, hue_calc, *hue);
-    
-    if (*hue < 0) {
-      *hue = *hue + 360;
-      ESP_LOGV(TAG, "Hue adjusted (was negative): now %d", *hue);
-    }
-    if (*hue >= 360) {
-      *hue = *hue - 360;
-      ESP_LOGV(TAG, "Hue adjusted (was >= 360): now %d", *hue);
-    }
-  }
-
-  ESP_LOGD(TAG, "RGB->HSB conversion complete: H=%d° S=%d%% B=%d%%", *hue, *saturation, *brightness);
-  
-  // Validation of output ranges
-  if (*hue < 0 || *hue >= 360) {
-    ESP_LOGW(TAG, "Hue out of valid range [0-359]: %d", *hue);
-  }
-  if (*saturation > 100) {
-    ESP_LOGW(TAG, "Saturation out of valid range [0-100]: %d", *saturation);
-  }
-  if (*brightness > 100) {
-    ESP_LOGW(TAG, "Brightness out of valid range [0-100]: %d", *brightness);
+  // The following logic is to handle different message modes on the NW660RGB
+  // in contention with the colour interlock mode which sets the inactive mode
+  // to zeroes. With both at zero, stay in whichever mode the light is already in.
+  if (rgb_is_zero && (!wb_is_zero || this->mode_frame_class_ == NeewerCommandClass::CCT)) {
+    ESP_LOGD(TAG, "-> WHITE MODE: RGB is zero");
+    this->prepare_ctwb_msg(color_temperature, white_brightness, packet);
+    return NeewerCommandClass::CCT;
   }
-};
-
-void NeewerRGBCTLightOutput::write_state(light_ns::LightState *state) {
-  // Call original write state to set new values for each state.
-  float red, green, blue, color_temperature, white_brightness;
-
-  state->current_values_as_rgbct(&red, &green, &blue, &color_temperature, &white_brightness);
-  const bool target_on = state->current_values.is_on();
-
-  ESP_LOGD(TAG, "Light state update: RGB(%.2f,%.2f,%.2f) CT=%.0fK WB=%.1f%%", 
-           red, green, blue, color_temperature, white_brightness * 100);
+  if (!wb_is_zero)
+    ESP_LOGD(TAG, "-> RGB FALLBACK: both modes active, defaulting to RGB");
+  else
+    ESP_LOGD(TAG, "-> RGB MODE: white brightness is zero");
+  this->prepare_rgb_msg(red, green, blue, packet);
+  return NeewerCommandClass::HSI;
+}
 
-  if (!target_on) {
+// Bring the light to an encoded target: power first if needed, then the mode
+// frame. Returns the queue sequence of the frame that carries the target, or 0
+// when nothing had to be sent.
+uint32_t NeewerRGBCTLightOutput::apply_target(const NeewerLightTarget &target, const NeewerPacket &frame,
+                                              NeewerCommandClass frame_class, NeewerPriority priority) {
+  uint32_t sequence = 0;
+  this->desired_on_ = target.on;
+  this->has_desired_ = true;
+  if (!target.on) {
     ESP_LOGI(TAG, "-> POWER OFF: Light requested to turn off");
-    this->send_power_command_(false);
-    this->request_status_refresh_(false);
-    this->set_old_rgbct(0.0f, 0.0f, 0.0f, color_temperature, 0.0f);
-    return;
+    if (this->send_power_command_(false))
+      sequence = this->last_queued_sequence_;
+    this->schedule_verification_();
+    return sequence;
   }
 
+  // Power and status requests are prepared in msg_, which may hold the frame.
+  const NeewerPacket mode_frame = frame;
+  this->desired_frame_ = frame;
+  this->desired_frame_class_ = frame_class;
+  this->desired_target_ = target;
+  if (frame_class == NeewerCommandClass::HSI) {
+    // Scenes take their hue, saturation and brightness from the colour going out,
+    // whoever encoded it (a group, an effect table). The HSI bytes end every
+    // colour frame, right before the checksum.
+    const uint8_t *hsi = frame.data() + frame.size() - 5;
+    this->last_hue_degrees_ = hsi[0] | (hsi[1] << 8);
+    this->last_saturation_percent_ = hsi[2];
+    this->last_rgb_brightness_fraction_ = hsi[3] / 100.0f;
+  }
   if (!this->light_on_) {
     this->send_power_command_(true);
-    this->request_status_refresh_(false);
+    this->schedule_verification_();
   }
 
-  // Prep values for logic to determine which mode we need to change
-  bool rgb_changed = this->did_rgb_change(red, green, blue);
-  bool ctwb_changed = this->did_ctwb_change(color_temperature, white_brightness);
-  bool only_wb_changed = this->did_only_wb_change(color_temperature, white_brightness);
-  bool rgb_is_zero = (red == 0.0 && green == 0.0) && blue == 0.0;
-  bool wb_is_zero = white_brightness == 0.0;
-  bool nothing_changed = !rgb_changed && !ctwb_changed;
-  
-  ESP_LOGD(TAG, "Change analysis: RGB %s, CTWB %s, RGB_zero=%s, WB_zero=%s",
-           rgb_changed ? "CHANGED" : "same", 
-           ctwb_changed ? "CHANGED" : "same",
-           rgb_is_zero ? "YES" : "NO",
-           wb_is_zero ? "YES" : "NO");
-
-  ESP_LOGD(TAG, "Previous values: RGB(%.2f,%.2f,%.2f) CT=%.0fK WB=%.1f%%",
-           this->old_red_, this->old_green_, this->old_blue_, 
-           this->old_color_temperature_, this->old_white_brightness_ * 100);
-
-  // The following logic is to handle different message modes on the NW660RGB
-  // in contention with the colour interlock mode which sets the inactive mode
-  // to zeroes.
-  
-  ESP_LOGD(TAG, "Mode decision logic:");
-  
-  if (rgb_changed && wb_is_zero) {
-    ESP_LOGI(TAG, "-> RGB MODE: RGB values changed, white brightness is zero");
-    this->prepare_rgb_msg(red, green, blue);
-    
-  } else if (ctwb_changed && rgb_is_zero) {
-    ESP_LOGI(TAG, "-> WHITE MODE: Color temp/brightness changed, RGB is zero");
-    
-    if (only_wb_changed) {
-      ESP_LOGD(TAG, "   Using brightness-only message (CT unchanged)");
-      this->prepare_wb_msg(white_brightness);
-    } else {
-      ESP_LOGD(TAG, "   Using full CTWB message (both CT and brightness changed)");
-      this->prepare_ctwb_msg(color_temperature, white_brightness);
-    }
-    
-  } else {
-    if (nothing_changed && rgb_is_zero) {
-      // If nothing changed while in CTWB mode, the RGB values will
-      // end up all zero effectively turning off the light if sent.
-      // Instead bail and don't write anything to the light.
-      ESP_LOGI(TAG, "-> NO ACTION: Nothing changed while in white mode, skipping transmission");
-      return;
-    }
-    
-    ESP_LOGI(TAG, "-> RGB FALLBACK: Complex state or conflicting modes, defaulting to RGB");
-    ESP_LOGD(TAG, "   Reason: RGB_changed=%s CTWB_changed=%s RGB_zero=%s WB_zero=%s",
-             rgb_changed ? "true" : "false", ctwb_changed ? "true" : "false",
-             rgb_is_zero ? "true" : "false", wb_is_zero ? "true" : "false");
-    this->prepare_rgb_msg(red, green, blue);
+  // Change detection happens on the encoded frame: a frame that is byte-identical
+  // to the one the light holds (or is about to) is dropped by queue_msg_.
+  this->msg_ = mode_frame;
+  if (this->queue_msg_(frame_class, priority)) {
+    sequence = this->last_queued_sequence_;
+    this->schedule_verification_();
   }
+  return sequence;
+}
 
-  // Message having been prepared, we can send it off into the sunset.
-  ESP_LOGD(TAG, "Sending prepared message to BLE layer...");
-  NeewerBLEOutput::write_state(1.0);
-  if (!this->status_query_active_) {
-    this->request_status_refresh_(true);
-  }
+// Members of a group may share one encoded frame when every input to the encoder
+// matches; the current mode matters because it decides the all-zero case. Frames
+// addressed to one light's MAC are never shared.
+bool NeewerRGBCTLightOutput::shares_encoding_with(const NeewerRGBCTLightOutput &other) const {
+  return !this->addressed_frames_() && this->model_name_() == other.model_name_() &&
+         this->green_magenta_bias_ == other.green_magenta_bias_ &&
+         this->cold_white_temperature_ == other.cold_white_temperature_ &&
+         this->warm_white_temperature_ == other.warm_white_temperature_ &&
+         this->mode_frame_class_ == other.mode_frame_class_;
+}
 
-  // We're probably done with the old values now, so let's change them up.
-  ESP_LOGD(TAG, "Updating stored previous values for next comparison");
-  this->set_old_rgbct(red, green, blue, color_temperature, white_brightness);
-};
+bool NeewerRGBCTLightOutput::holds_link() const {
+  if (this->link_wanted_ || !this->link_idle() || this->frame_pending_ || this->resync_active_ ||
+      this->verify_pending_ || this->awaiting_power_status_ || this->awaiting_channel_status_)
+    return true;
+  return this->light_state_ != nullptr && this->light_state_->get_effect_name() != "None";
+}
 
 void NeewerRGBCTLightOutput::loop() {
+  if (this->frame_pending_ && millis() - this->last_frame_ms_ >= this->min_frame_interval_ms_)
+    this->emit_pending_frame_();
   NeewerBLEOutput::loop();
   this->check_status_timeouts_();
+  this->run_verification_();
+  if (this->poll_interval_ms_ != 0 && this->notify_registered_ &&
+      millis() - this->last_poll_ms_ >= this->poll_interval_ms_) {
+    this->last_poll_ms_ = millis();
+    this->request_status_refresh_(this->track_channel_);
+  }
 }
 
-void NeewerRGBCTLightOutput::set_old_rgbct(float red, float green, float blue, float color_temperature,
-                                           float white_brightness) {
-  this->old_red_ = red;
-  this->old_green_ = green;
-  this->old_blue_ = blue;
-  this->old_color_temperature_ = color_temperature;
-  this->old_white_brightness_ = white_brightness;
+// Round a target onto the grid the light actually resolves: whole brightness
+// percents and whole CCT bytes. Targets that only differ below that resolution
+// then compare equal and don't produce a frame. The encoders round the same way,
+// so a snapped value encodes to exactly the byte it was snapped to. A light that
+// is on never snaps down to 0%, which the panel would show as dark.
+void NeewerRGBCTLightOutput::snap_to_device_resolution_(NeewerLightTarget *target) const {
+  const float white_brightness = clamp(target->white_brightness, 0.0f, 1.0f);
+  if (white_brightness > 0.0f)
+    target->white_brightness = std::max(roundf(white_brightness * 100.0f), 1.0f) / 100.0f;
+  else
+    target->white_brightness = 0.0f;
+
+  const float rgb_max = std::max(target->red, std::max(target->green, target->blue));
+  if (rgb_max > 0.0f) {
+    // Scale the colour so its brightness lands on a whole percent; hue and saturation are unchanged.
+    const float snapped_max = std::max(roundf(clamp(rgb_max, 0.0f, 1.0f) * 100.0f), 1.0f) / 100.0f;
+    const float scale = snapped_max / rgb_max;
+    target->red *= scale;
+    target->green *= scale;
+    target->blue *= scale;
+  }
 
-  this->red_->set_level(red);
-  this->green_->set_level(green);
-  this->blue_->set_level(blue);
-  this->color_temperature_->set_level(color_temperature);
-  this->white_brightness_->set_level(white_brightness);
+  this->snap_color_temperature_(target);
 }
 
-bool NeewerRGBCTLightOutput::activate_scene(uint8_t scene_id) {
-  const NeewerSceneDefinition *definition = nullptr;
-  for (size_t i = 0; i < NEEWER_SIMPLE_SCENE_COUNT; i++) {
-    if (NEEWER_SIMPLE_SCENES[i].scene_id == scene_id) {
-      definition = &NEEWER_SIMPLE_SCENES[i];
-      break;
-    }
-  }
-  if (definition == nullptr) {
-    ESP_LOGW(TAG, "Scene id %u not supported", scene_id);
+bool NeewerRGBCTLightOutput::activate_scene(uint8_t scene_id, float brightness) {
+  this->scene_brightness_ = clamp(brightness, 0.0f, 1.0f);
+  const NeewerSceneDefinition *scene = this->prepare_scene_msg_(scene_id);
+  if (scene == nullptr) {
+    ESP_LOGW(TAG, "Scene id %u not supported by %s", scene_id, this->model_name_());
     return false;
   }
-  if (!this->build_scene_message_(*definition)) {
-    ESP_LOGW(TAG, "Unable to build scene payload for id %u", scene_id);
-    return false;
-  }
-  ESP_LOGI(TAG, "Activating scene '%s' (id %u)", definition->name, scene_id);
-  NeewerBLEOutput::write_state(1.0f);
-  this->request_status_refresh_(false);
+  const NeewerPacket scene_frame = this->msg_;
+  this->desired_frame_ = scene_frame;
+  this->desired_frame_class_ = NeewerCommandClass::FX;
+  this->desired_on_ = true;
+  this->has_desired_ = true;
+  ESP_LOGI(TAG, "Activating scene '%s' (id %u)", scene->name, scene_id);
+  // A scene started on a light in standby (e.g. from sACN) powers it on first.
+  if (!this->light_on_)
+    this->send_power_command_(true);
+  this->msg_ = scene_frame;
+  if (this->queue_msg_(NeewerCommandClass::FX))
+    this->schedule_verification_();
   return true;
 }
 
-bool NeewerRGBCTLightOutput::build_scene_message_(const NeewerSceneDefinition &definition) {
-  this->orig_msg_clear();
-  this->orig_msg_[0] = this->command_prefix_;
-  this->orig_msg_[1] = FX_SUBTAG;
-  uint8_t index = 3;
-  const float scene_kelvin = this->normalized_ct_to_kelvin_(this->old_color_temperature_);
-  this->orig_msg_[index++] = definition.scene_id;
-
-  for (uint8_t i = 0; i < definition.param_count; i++) {
-    const auto &spec = definition.params[i];
-    switch (spec.kind) {
-      case NeewerSceneParamKind::BRR:
-        this->orig_msg_[index++] = this->current_brightness_byte_();
-        break;
-      case NeewerSceneParamKind::BRR2:
-        this->orig_msg_[index++] = this->current_brightness_byte_(true);
-        break;
-      case NeewerSceneParamKind::CCT:
-        this->orig_msg_[index++] = this->convert_kelvin_to_scene_byte_(scene_kelvin);
-        break;
-      case NeewerSceneParamKind::CCT2:
-        this->orig_msg_[index++] = this->convert_kelvin_to_scene_byte_(scene_kelvin);
-        break;
-      case NeewerSceneParamKind::GM:
-        this->orig_msg_[index++] = this->gm_bias_byte_();
-        break;
-      case NeewerSceneParamKind::SPEED:
-        this->orig_msg_[index++] = this->default_speed_byte_();
-        break;
-      case NeewerSceneParamKind::SPARKS:
-        this->orig_msg_[index++] = this->default_sparks_byte_();
-        break;
-      case NeewerSceneParamKind::HUE16: {
-        uint16_t hue = this->current_hue_degrees_();
-        this->orig_msg_[index++] = static_cast<uint8_t>(hue & 0xFF);
-        this->orig_msg_[index++] = static_cast<uint8_t>((hue >> 8) & 0xFF);
-        break;
-      }
-      case NeewerSceneParamKind::SAT:
-        this->orig_msg_[index++] = this->current_saturation_percent_();
-        break;
-      case NeewerSceneParamKind::COLOR:
-        this->orig_msg_[index++] = this->default_color_byte_();
-        break;
-    }
-    if (index >= MSG_MAX_SIZE - 1) {
-      ESP_LOGW(TAG, "Scene payload would overflow buffer");
-      return false;
-    }
-  }
-
-  this->orig_msg_[2] = index - 3;
-  this->orig_msg_len_ = index;
-  NeewerBLEOutput::build_msg_with_checksum();
-  return true;
+// Live values for every scene parameter source; a scene layout picks from these.
+void NeewerRGBCTLightOutput::fill_scene_bytes_(uint8_t *live, uint8_t cct_byte) const {
+  const uint16_t hue = this->current_hue_degrees_();
+  live[static_cast<uint8_t>(NeewerSceneByte::BRR)] = this->current_brightness_byte_();
+  live[static_cast<uint8_t>(NeewerSceneByte::BRR2)] = this->current_brightness_byte_(true);
+  live[static_cast<uint8_t>(NeewerSceneByte::CCT)] = cct_byte;
+  live[static_cast<uint8_t>(NeewerSceneByte::GM)] = this->gm_bias_byte_();
+  live[static_cast<uint8_t>(NeewerSceneByte::SPEED)] = this->default_speed_byte_();
+  live[static_cast<uint8_t>(NeewerSceneByte::SPARKS)] = this->default_sparks_byte_();
+  live[static_cast<uint8_t>(NeewerSceneByte::HUE_LSB)] = static_cast<uint8_t>(hue & 0xFF);
+  live[static_cast<uint8_t>(NeewerSceneByte::HUE_MSB)] = static_cast<uint8_t>(hue >> 8);
+  live[static_cast<uint8_t>(NeewerSceneByte::SAT)] = this->current_saturation_percent_();
+  live[static_cast<uint8_t>(NeewerSceneByte::COLOR)] = this->default_color_byte_();
 }
 
 uint8_t NeewerRGBCTLightOutput::current_brightness_byte_(bool secondary) const {
@@ -713,7 +1009,11 @@ uint8_t NeewerRGBCTLightOutput::current_brightness_byte_(bool secondary) const {
       value = 100;
     return static_cast<uint8_t>(value);
   };
-  int primary = static_cast<int>(roundf(this->old_white_brightness_ * 100.0f));
+  int primary = 0;
+  if (this->scene_brightness_ > 0.0f)
+    primary = static_cast<int>(roundf(this->scene_brightness_ * 100.0f));
+  else if (this->desired_target_.on)
+    primary = static_cast<int>(roundf(this->desired_target_.white_brightness * 100.0f));
   if (primary <= 0) {
     primary = static_cast<int>(roundf(this->last_rgb_brightness_fraction_ * 100.0f));
   }
@@ -727,24 +1027,7 @@ uint8_t NeewerRGBCTLightOutput::current_brightness_byte_(bool secondary) const {
   return clamp_byte(secondary_value);
 }
 
-uint8_t NeewerRGBCTLightOutput::convert_kelvin_to_scene_byte_(float kelvin) const {
-  float effective = kelvin;
-  if (effective <= 0.0f)
-    effective = (this->kelvin_min_ + this->kelvin_max_) / 2.0f;
-  effective = clamp(effective, this->kelvin_min_, this->kelvin_max_);
-  const float span = this->kelvin_max_ - this->kelvin_min_;
-  const float normalized = span > 0.0f ? (effective - this->kelvin_min_) / span : 0.5f;
-  int mapped = static_cast<int>(roundf(29.0f + normalized * (70.0f - 29.0f)));
-  if (mapped < 29)
-    mapped = 29;
-  if (mapped > 70)
-    mapped = 70;
-  return static_cast<uint8_t>(mapped);
-}
-
 uint16_t NeewerRGBCTLightOutput::current_hue_degrees_() const {
-  if (this->last_hue_degrees_ == 0 && this->old_red_ == 0.0f && this->old_green_ == 0.0f && this->old_blue_ == 0.0f)
-    return 0;
   return clamp<uint16_t>(this->last_hue_degrees_, 0, 360);
 }
 
@@ -779,9 +1062,7 @@ void NeewerRGBCTLightOutput::request_power_status_(bool force) {
 
   ESP_LOGD(TAG, "Requesting power status (force=%s)", force ? "true" : "false");
   this->prepare_status_msg_(POWER_STATUS_REQUEST_TAG);
-  this->status_query_active_ = true;
-  NeewerBLEOutput::write_state(1.0f);
-  this->status_query_active_ = false;
+  this->queue_msg_(NeewerCommandClass::POWER_STATUS);
   this->awaiting_power_status_ = true;
   this->last_power_request_ms_ = millis();
 }
@@ -794,9 +1075,7 @@ void NeewerRGBCTLightOutput::request_channel_status_(bool force) {
 
   ESP_LOGD(TAG, "Requesting channel status (force=%s)", force ? "true" : "false");
   this->prepare_status_msg_(CHANNEL_STATUS_REQUEST_TAG);
-  this->status_query_active_ = true;
-  NeewerBLEOutput::write_state(1.0f);
-  this->status_query_active_ = false;
+  this->queue_msg_(NeewerCommandClass::CHANNEL_STATUS);
   this->awaiting_channel_status_ = true;
   this->last_channel_request_ms_ = millis();
 }
@@ -809,6 +1088,107 @@ void NeewerRGBCTLightOutput::request_status_refresh_(bool include_channel) {
   }
 }
 
+// Instead of polling after every frame, one status check goes out once the light
+// has been quiet for status_verify_delay. Bursts of frames (a slider drag, a
+// transition) therefore cost a single check at the end.
+void NeewerRGBCTLightOutput::schedule_verification_() { this->verify_pending_ = true; }
+
+void NeewerRGBCTLightOutput::run_verification_() {
+  if (!this->verify_pending_ || this->awaiting_power_status_)
+    return;
+  if (this->write_in_flight_() || !this->command_queue_.empty())
+    return;
+  const uint32_t delay = this->verify_retries_ > 0 ? STATUS_RETRY_MS : this->verify_delay_ms_;
+  if (millis() - this->last_activity_ms_ < delay)
+    return;
+  this->verify_pending_ = false;
+  this->request_status_refresh_(this->track_channel_);
+}
+
+// After a timeout or a failed write the light is checked again on a short fuse,
+// a few times, until it answers.
+void NeewerRGBCTLightOutput::verification_failed_(const char *reason) {
+  if (this->verify_retries_ >= STATUS_MAX_RETRIES) {
+    ESP_LOGD(TAG, "Status verification gave up after %u retries (%s)", this->verify_retries_, reason);
+    return;
+  }
+  this->verify_retries_++;
+  this->verify_pending_ = true;
+  ESP_LOGD(TAG, "Status verification retry %u scheduled (%s)", this->verify_retries_, reason);
+}
+
+void NeewerRGBCTLightOutput::write_failed_(NeewerCommandClass command_class) {
+  this->verification_failed_("write failed");
+}
+
+// The light acknowledged a frame, so it now holds that state. This is what a
+// reconnect diffs against.
+void NeewerRGBCTLightOutput::write_acked_(NeewerCommandClass command_class, const NeewerPacket &packet) {
+  if (is_mode_class(command_class)) {
+    this->confirmed_frame_ = packet;
+  } else if (command_class == NeewerCommandClass::POWER) {
+    // The on/off byte is the last before the checksum, addressed frames or not.
+    this->confirmed_power_ = packet.data()[packet.size() - 2] == POWER_ON ? NeewerPowerState::ON
+                                                                           : NeewerPowerState::STANDBY;
+  }
+
+  if (this->resync_active_ && this->is_acknowledged(this->resync_sequence_)) {
+    this->resync_active_ = false;
+    this->finish_resync_();
+  }
+}
+
+// After a reconnect the light still shows whatever it had when the link dropped,
+// while the desired state may have moved on. Send only what differs from the
+// last confirmed state, as one burst that the queue paces out.
+void NeewerRGBCTLightOutput::connection_ready_() {
+  this->resync_active_ = false;
+  this->resync_frames_ = 0;
+  if (!this->has_desired_) {
+    this->finish_resync_();
+    return;
+  }
+
+  uint32_t last_sequence = 0;
+  const NeewerPowerState desired_power = this->desired_on_ ? NeewerPowerState::ON : NeewerPowerState::STANDBY;
+  const bool power_differs = this->confirmed_power_ != desired_power;
+  if (power_differs && this->send_power_command_(this->desired_on_)) {
+    last_sequence = this->last_queued_sequence_;
+    this->resync_frames_++;
+  }
+
+  if (this->desired_on_ && !this->desired_frame_.empty()) {
+    // Coming out of standby the mode frame is always resent (see queue_msg_).
+    if (power_differs || this->desired_frame_ != this->confirmed_frame_) {
+      this->msg_ = this->desired_frame_;
+      if (this->queue_msg_(this->desired_frame_class_)) {
+        last_sequence = this->last_queued_sequence_;
+        this->resync_frames_++;
+      }
+    } else {
+      this->acked_mode_frame_ = this->confirmed_frame_;
+      this->mode_frame_class_ = this->desired_frame_class_;
+    }
+  }
+
+  if (last_sequence == 0) {
+    this->finish_resync_();
+    return;
+  }
+  ESP_LOGI(TAG, "Resyncing light after reconnect: %u frame(s)", this->resync_frames_);
+  this->resync_sequence_ = last_sequence;
+  this->resync_active_ = true;
+  this->schedule_verification_();
+}
+
+void NeewerRGBCTLightOutput::finish_resync_() {
+  const uint32_t elapsed = millis() - this->connected_ms_;
+  this->stats_.resyncs++;
+  this->stats_.resync_frames += this->resync_frames_;
+  this->stats_.consistent_ms_last = elapsed;
+  ESP_LOGI(TAG, "Light consistent %ums after connecting (%u resync frame(s))", elapsed, this->resync_frames_);
+}
+
 void NeewerRGBCTLightOutput::status_notifications_ready_() {
   ESP_LOGI(TAG, "Status notifications enabled");
   this->awaiting_power_status_ = false;
@@ -819,48 +1199,71 @@ void NeewerRGBCTLightOutput::status_notifications_ready_() {
 void NeewerRGBCTLightOutput::status_notifications_lost_() {
   this->awaiting_power_status_ = false;
   this->awaiting_channel_status_ = false;
+  this->verify_pending_ = false;
+  this->verify_retries_ = 0;
 }
 
 void NeewerRGBCTLightOutput::schedule_initial_status_refresh_() {
   if (this->initial_status_requested_)
     return;
   this->initial_status_requested_ = true;
-  this->request_status_refresh_(true);
+  this->request_status_refresh_(this->track_channel_);
 }
 
-void NeewerRGBCTLightOutput::handle_status_notification_(const uint8_t *data, uint16_t length) {
-  if (length < 4) {
-    ESP_LOGW(TAG, "Status notify payload too short (%u bytes)", length);
-    return;
-  }
-
-  ESP_LOGD(TAG, "Status notification len=%u bytes: type=0x%02X payload=0x%02X", length, data[1], data[3]);
+// Notify frames are dispatched on their tag. A new response type only needs a
+// tag constant, a handler and an entry here.
+const NeewerRGBCTLightOutput::StatusHandler NeewerRGBCTLightOutput::STATUS_HANDLERS[STATUS_TAG_LIMIT] = {
+    nullptr,                                                   // 0x00
+    &NeewerRGBCTLightOutput::handle_channel_status_response_,  // CHANNEL_STATUS_RESPONSE_TAG
+    &NeewerRGBCTLightOutput::handle_power_status_response_,    // POWER_STATUS_RESPONSE_TAG
+};
 
-  const uint8_t response_type = data[1];
-  const uint8_t payload = data[3];
+void NeewerRGBCTLightOutput::handle_status_frame_(const NeewerPacket &frame) {
+  const uint8_t tag = frame.tag();
+  const uint8_t payload_length = frame.data()[2];
+  const uint8_t *payload = frame.data() + FRAME_HEADER_SIZE;
+  ESP_LOGD(TAG, "Status notification: tag=0x%02X, %u payload bytes", tag, payload_length);
 
-  if (response_type == POWER_STATUS_RESPONSE_TAG) {
-    this->awaiting_power_status_ = false;
-    this->handle_power_status_response_(payload);
-  } else if (response_type == CHANNEL_STATUS_RESPONSE_TAG) {
-    this->awaiting_channel_status_ = false;
-    this->handle_channel_status_response_(payload);
-  } else {
-    ESP_LOGW(TAG, "Unknown status notify type: 0x%02X", response_type);
+  const StatusHandler handler = tag < STATUS_TAG_LIMIT ? STATUS_HANDLERS[tag] : nullptr;
+  if (handler == nullptr) {
+    this->decoder_.note_unknown_tag();
+    ESP_LOGW(TAG, "Unknown status notify type: 0x%02X", tag);
+    return;
+  }
+  if (payload_length == 0) {
+    ESP_LOGW(TAG, "Status notify 0x%02X without payload", tag);
+    return;
   }
+  (this->*handler)(payload, payload_length);
 }
 
-void NeewerRGBCTLightOutput::handle_power_status_response_(uint8_t raw_state) {
-  if (raw_state == 0x01) {
+void NeewerRGBCTLightOutput::handle_power_status_response_(const uint8_t *payload, uint8_t length) {
+  if (this->awaiting_power_status_)
+    this->note_confirmation_latency_(millis() - this->last_power_request_ms_);
+  this->awaiting_power_status_ = false;
+  this->verify_retries_ = 0;
+
+  const uint8_t raw_state = payload[0];
+  if (raw_state == POWER_ON) {
+    this->confirmed_power_ = NeewerPowerState::ON;
     this->light_on_ = true;
     ESP_LOGD(TAG, "Power status confirmed: ON");
-  } else if (raw_state == 0x02) {
+  } else if (raw_state == POWER_STANDBY) {
+    this->confirmed_power_ = NeewerPowerState::STANDBY;
     this->light_on_ = false;
     ESP_LOGD(TAG, "Power status confirmed: STANDBY");
   } else {
     ESP_LOGW(TAG, "Unexpected power status value: 0x%02X", raw_state);
     return;
   }
+  // A read-back that was sent after the last user frame was acknowledged, and
+  // matches what was asked for: the command has landed. The stage times only the
+  // query's round trip, not the verify delay it waited out in front of it.
+  const bool sent_after_ack = static_cast<int32_t>(this->power_request_sent_us_ - this->confirm_acked_us_) >= 0;
+  if (this->confirm_acked_us_ != 0 && sent_after_ack && this->has_desired_ && this->light_on_ == this->desired_on_) {
+    this->record_latency_(NeewerLatencyStage::CONFIRM, this->power_request_sent_us_);
+    this->confirm_acked_us_ = 0;
+  }
 
   if (this->light_state_ != nullptr) {
     auto call = this->light_state_->make_call();
@@ -869,20 +1272,55 @@ void NeewerRGBCTLightOutput::handle_power_status_response_(uint8_t raw_state) {
   }
 }
 
-void NeewerRGBCTLightOutput::handle_channel_status_response_(uint8_t channel) {
+// The channel is only set from the light's own buttons. When it moves, someone
+// has been at the panel and may have changed more than the channel, so what the
+// light acknowledged earlier no longer tells what it shows: the next command goes
+// out in full and a reconnect resends the desired mode frame.
+void NeewerRGBCTLightOutput::handle_channel_status_response_(const uint8_t *payload, uint8_t length) {
+  this->awaiting_channel_status_ = false;
+  const uint8_t channel = payload[0];
+  if (this->channel_known_ && channel != this->channel_id_) {
+    ESP_LOGW(TAG, "Light channel changed from %u to %u on the light, forgetting its acknowledged state",
+             this->channel_id_, channel);
+    this->stats_.channel_changes++;
+    this->clear_mode_frames_();
+    this->confirmed_frame_.clear();
+  } else {
+    ESP_LOGD(TAG, "Channel status: %u", channel);
+  }
   this->channel_id_ = channel;
-  ESP_LOGD(TAG, "Channel status: %u", static_cast<unsigned>(channel));
+  this->channel_known_ = true;
+  this->stats_.channel = channel;
+}
+
+// A query held back for foreground traffic hasn't been sent yet; its timeout and
+// its round trip start once it leaves the queue.
+void NeewerRGBCTLightOutput::frame_sent_(NeewerCommandClass command_class) {
+  if (command_class == NeewerCommandClass::POWER_STATUS) {
+    this->last_power_request_ms_ = millis();
+    this->power_request_sent_us_ = micros();
+  } else if (command_class == NeewerCommandClass::CHANNEL_STATUS) {
+    this->last_channel_request_ms_ = millis();
+  }
 }
 
 void NeewerRGBCTLightOutput::check_status_timeouts_() {
   const uint32_t now = millis();
+  if (this->is_command_pending_(NeewerCommandClass::POWER_STATUS) ||
+      this->is_command_pending_(NeewerCommandClass::CHANNEL_STATUS))
+    return;
   if (this->awaiting_power_status_ && now - this->last_power_request_ms_ > STATUS_TIMEOUT_MS) {
     ESP_LOGW(TAG, "Power status request timed out");
     this->awaiting_power_status_ = false;
+    this->stats_.status_timeouts++;
+    this->note_link_loss_("status timeout");
+    this->verification_failed_("status timeout");
   }
   if (this->awaiting_channel_status_ && now - this->last_channel_request_ms_ > STATUS_TIMEOUT_MS) {
     ESP_LOGW(TAG, "Channel status request timed out");
     this->awaiting_channel_status_ = false;
+    this->stats_.status_timeouts++;
+    this->note_link_loss_("status timeout");
   }
 }
 
@@ -912,10 +1350,6 @@ NeewerRGBCTLightOutput::NeewerRGBCTLightOutput() {
   this->set_blue(new NeewerStateOutput());
   this->set_color_temperature(new NeewerStateOutput());
   this->set_white_brightness(new NeewerStateOutput());
-  this->set_cold_white_temperature(COLD_WHITE);
-  this->set_warm_white_temperature(WARM_WHITE);
-
-  NeewerBLEOutput();
 
   // Assume colour interlock is on as the NW660 definitely treats RGB and CT as separate modes
   // this->set_color_interlock(true);
@@ -9,6 +9,11 @@
 #include "../../core/helpers.h"
 #include "../../core/component.h"
 #include "../../core/log.h"
+#include "../../core/preferences.h"
+#include "neewer_color.h"
+#include "neewer_latency.h"
+#include "neewer_packet_trace.h"
+#include "neewer_protocol.h"
 
 #ifdef USE_ESP32
 
@@ -21,38 +26,200 @@ namespace light_ns = ::esphome::light;
 static const char *const SERVICE_UUID = "69400001-B5A3-F393-E0A9-E50E24DCCA99";
 static const char *const CHARACTERISTIC_UUID = "69400002-B5A3-F393-E0A9-E50E24DCCA99";
 static const char *const NOTIFY_CHARACTERISTIC_UUID = "69400003-B5A3-F393-E0A9-E50E24DCCA99";
-static const int MSG_MAX_SIZE = 20;  // size of msg_ string to reserve in bytes (uint8_t*).
-static const float COLD_WHITE = 178.6;  // 5600 K
-static const float WARM_WHITE = 312.5;  // 3200 K
 
-enum class NeewerSceneParamKind : uint8_t {
-    BRR,
+// Source of each payload byte in a scene frame. Hue travels as two bytes, LSB first.
+enum class NeewerSceneByte : uint8_t {
+    BRR = 0,
     BRR2,
     CCT,
-    CCT2,
     GM,
     SPEED,
     SPARKS,
-    HUE16,
+    HUE_LSB,
+    HUE_MSB,
     SAT,
     COLOR,
 };
+static const uint8_t SCENE_BYTE_SOURCE_COUNT = 10;
+static const uint8_t SCENE_MAX_PARAM_BYTES = 8;
+static const uint8_t SCENE_HEADER_SIZE = 4;  // prefix, tag, payload length, scene id
 
-struct NeewerSceneParamSpec {
-    NeewerSceneParamKind kind;
-};
-
+// Scene layouts are built at compile time (see neewer_scene in neewer_model.h), so
+// the fixed header and its checksum contribution are known up front; only the
+// parameter bytes are filled in when a scene is activated.
 struct NeewerSceneDefinition {
     uint8_t scene_id;
     const char *name;
-    const NeewerSceneParamSpec *params;
     uint8_t param_count;
+    NeewerSceneByte params[SCENE_MAX_PARAM_BYTES];
+    uint8_t header[SCENE_HEADER_SIZE];
+    uint8_t header_checksum;
+};
+
+// Outgoing frames are coalesced per command class: only the newest frame of each
+// class is kept while waiting for the previous write to be acknowledged.
+enum class NeewerCommandClass : uint8_t {
+    POWER = 0,
+    HSI,
+    CCT,
+    FX,
+    POWER_STATUS,
+    CHANNEL_STATUS,
+};
+static const uint8_t COMMAND_CLASS_COUNT = 6;
+
+// Colour, white and scene frames each define the whole light output.
+inline bool is_mode_class(NeewerCommandClass command_class) {
+  return command_class == NeewerCommandClass::HSI || command_class == NeewerCommandClass::CCT ||
+         command_class == NeewerCommandClass::FX;
+}
+// Scheduling priority of a queued frame, most urgent first. Whatever waits in a
+// more urgent class goes out first; background status queries additionally wait
+// until no other frame has been queued for BACKGROUND_QUIET_MS.
+enum class NeewerPriority : uint8_t {
+    POWER = 0,
+    USER,
+    EFFECT,
+    BACKGROUND,
+};
+static const uint32_t BACKGROUND_QUIET_MS = 100;
+
+inline NeewerPriority default_priority(NeewerCommandClass command_class) {
+  if (command_class == NeewerCommandClass::POWER)
+    return NeewerPriority::POWER;
+  return is_mode_class(command_class) ? NeewerPriority::USER : NeewerPriority::BACKGROUND;
+}
+static const uint32_t WRITE_ACK_TIMEOUT_MS = 1000;
+// Unacknowledged writes are paced at roughly one connection event apart.
+static const uint32_t NO_RSP_WRITE_INTERVAL_MS = 15;
+// Losses within the window that switch a light back to acknowledged writes, and
+// how long it stays there before the fast path is tried again.
+static const uint8_t FAST_PATH_LOSS_THRESHOLD = 3;
+static const uint32_t FAST_PATH_LOSS_WINDOW_MS = 10000;
+static const uint32_t FAST_PATH_RETRY_MS = 60000;
+// A write without response completes once it has left the controller. When the
+// recent completion time climbs this far above twice its long-run level, frames
+// are piling up in front of the radio, and each such write counts as a loss.
+static const uint32_t FAST_PATH_LATENCY_MARGIN_MS = 20;
+
+// A write handed to the stack that has not completed yet. ESP_GATTC_WRITE_CHAR_EVT
+// names neither the write type nor the frame, but the stack completes a
+// connection's writes in order, so each event belongs to the oldest slot.
+struct NeewerWriteSlot {
+    uint32_t sequence = 0;
+    esp_gatt_write_type_t write_type = ESP_GATT_WRITE_TYPE_RSP;
+    uint16_t handle = 0;
+    NeewerCommandClass command_class = NeewerCommandClass::HSI;
+    NeewerPriority priority = NeewerPriority::USER;
+    uint32_t origin_us = 0;
+    uint32_t sent_ms = 0;
+    // Timed out and already counted as failed; its late event is dropped.
+    bool abandoned = false;
+    NeewerPacket packet;
+};
+static const uint8_t WRITE_SLOT_COUNT = 4;
+
+class NeewerCommandQueue {
+ public:
+    uint32_t push(NeewerCommandClass command_class, NeewerPriority priority, const NeewerPacket &packet,
+                  uint32_t origin_us);
+    bool pop(NeewerPacket *packet, NeewerCommandClass *command_class, uint32_t *sequence, NeewerPriority *priority,
+             uint32_t *origin_us, bool allow_background);
+    bool is_pending(NeewerCommandClass command_class) const;
+    bool empty() const;
+    bool has_foreground() const;
+    void clear();
+    uint32_t get_coalesced_count() const { return this->coalesced_count_; }
+
+ protected:
+    struct Slot {
+      NeewerPacket packet;
+      uint32_t sequence = 0;
+      NeewerPriority priority = NeewerPriority::USER;
+      uint32_t origin_us = 0;  // light call, or queue time for frames without one
+      bool pending = false;
+    };
+    void drop_(NeewerCommandClass command_class);
+
+    Slot slots_[COMMAND_CLASS_COUNT];
+    // Starts at 1 so that 0 can mean "no frame".
+    uint32_t next_sequence_ = 1;
+    uint32_t coalesced_count_ = 0;
+};
+
+// Cumulative traffic and encode cost for one light, logged as a JSON line every
+// stats_interval so a replayed workload can be compared before/after a change.
+struct NeewerLinkStats {
+    uint32_t light_calls = 0;
+    uint32_t frames_sent = 0;
+    uint32_t bytes_sent = 0;
+    uint32_t frames_by_class[COMMAND_CLASS_COUNT] = {};
+    uint32_t encodes = 0;
+    uint32_t encode_us = 0;
+    uint32_t resyncs = 0;
+    uint32_t resync_frames = 0;
+    uint32_t consistent_ms_last = 0;
+    uint32_t ready_ms_last = 0;
+    uint32_t handle_cache_hits = 0;
+    uint32_t handle_cache_misses = 0;
+    // Power and user frames: light call to acknowledged, and how many had to wait
+    // for a background write already on the air.
+    uint32_t user_frames = 0;
+    uint64_t user_latency_us_total = 0;
+    uint32_t user_latency_us_max = 0;
+    uint32_t user_behind_background = 0;
+    uint32_t write_failures = 0;
+    uint32_t status_timeouts = 0;
+    // With track_channel: the channel last read back (0 until then) and how often
+    // it changed since the first read.
+    uint8_t channel = 0;
+    uint32_t channel_changes = 0;
+};
+
+// GATT handles of one light, persisted so a reconnect can skip discovery.
+struct NeewerHandleCache {
+    uint16_t write_handle;
+    uint16_t notify_handle;
+    uint16_t cccd_handle;
+} __attribute__((packed));
+
+enum class NeewerPowerState : uint8_t {
+    UNKNOWN = 0,
+    ON,
+    STANDBY,
+};
+
+// Light values requested by ESPHome, waiting to be encoded into a frame.
+struct NeewerLightTarget {
+    bool on = false;
+    float red = 0.0f;
+    float green = 0.0f;
+    float blue = 0.0f;
+    float color_temperature = 0.0f;
+    float white_brightness = 0.0f;
+};
+
+// BLE connection parameters in controller units: intervals in 1.25 ms steps, the
+// supervision timeout in 10 ms steps. A zero max_interval means "not configured".
+struct NeewerConnParams {
+    uint16_t min_interval = 0;
+    uint16_t max_interval = 0;
+    uint16_t latency = 0;
+    uint16_t timeout = 0;
+};
+
+// Lights that are changing ask for a short connection interval; once quiet for
+// idle_after they drop back to a relaxed one to free up radio time.
+enum class NeewerConnProfile : uint8_t {
+    NONE = 0,
+    ACTIVE,
+    IDLE,
 };
 
 class NeewerBLEOutput : public Component, public output::FloatOutput, public ble_client::BLEClientNode {
  public:
     void dump_config() override;
-    void loop() override {}
+    void loop() override;
     float get_setup_priority() const override {
       return setup_priority::DATA;
     }
@@ -67,44 +234,179 @@ class NeewerBLEOutput : public Component, public output::FloatOutput, public ble
     void set_notify_char_uuid_str(const char *uuid) { this->notify_char_uuid_ = espbt::ESPBTUUID::from_raw(uuid); }
     void gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if,
                             esp_ble_gattc_cb_param_t *param) override;
+    void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) override;
+    void set_active_conn_params(uint16_t min_interval, uint16_t max_interval, uint16_t latency, uint16_t timeout) {
+      this->active_conn_params_ = NeewerConnParams{min_interval, max_interval, latency, timeout};
+    }
+    void set_idle_conn_params(uint16_t min_interval, uint16_t max_interval, uint16_t latency, uint16_t timeout) {
+      this->idle_conn_params_ = NeewerConnParams{min_interval, max_interval, latency, timeout};
+    }
+    void set_idle_after(uint32_t idle_after_ms) { this->idle_after_ms_ = idle_after_ms; }
+    void set_mtu(uint16_t mtu) { this->mtu_ = mtu; }
     void set_require_response(bool response) { this->require_response_ = response; }
-
-    NeewerBLEOutput();
+    uint32_t get_suppressed_writes() const { return this->suppressed_writes_; }
+    void set_packet_trace(bool enabled);
+    void set_stats_interval(uint32_t interval_ms) { this->stats_interval_ms_ = interval_ms; }
+    const NeewerLinkStats &get_stats() const { return this->stats_; }
+    const NeewerLatencyHistogram &get_latency(NeewerLatencyStage stage) const {
+      return this->latency_[static_cast<uint8_t>(stage)];
+    }
+    // Queue sequences grow monotonically, and a later frame for the same class
+    // supersedes an earlier one, so an ack at or past a sequence covers it.
+    uint8_t get_light_id() const { return this->light_id_; }
+    bool is_acknowledged(uint32_t sequence) const { return this->acked_sequence_ >= sequence; }
+    uint32_t get_acked_us() const { return this->acked_us_; }
+    // Nothing but background frames queued and no write waiting for its ack: a
+    // new frame goes out right away.
+    bool link_idle() const { return !this->write_in_flight_() && !this->command_queue_.has_foreground(); }
+    // Used by neewerlight_pool, which opens the connection only when the light has
+    // something to send. A pooled light keeps commands that arrive while it is
+    // disconnected in its desired state and flags that it wants a link.
+    void set_pooled(bool pooled) { this->pooled_ = pooled; }
+    bool link_wanted() const { return this->link_wanted_; }
+    bool is_connected() const { return this->client_state_ == espbt::ClientState::ESTABLISHED; }
+    bool is_link_ready() const { return this->handles_ready_; }
 
   protected:
     void write_state(float state) override;
-    void build_msg_with_checksum();
-    void msg_clear();
-    void orig_msg_clear();
+    bool queue_msg_(NeewerCommandClass command_class) {
+      return this->queue_msg_(command_class, default_priority(command_class));
+    }
+    bool queue_msg_(NeewerCommandClass command_class, NeewerPriority priority);
+    void pump_queue_();
+    bool resolve_write_handle_();
+    bool transmit_(NeewerPacket &packet, esp_gatt_write_type_t write_type);
+    esp_gatt_write_type_t write_type_for_(NeewerCommandClass command_class);
+    // A write the stack still owes an event for; abandoned ones don't count.
+    bool write_in_flight_() const;
+    NeewerWriteSlot &write_slot_(uint8_t index) {
+      return this->write_slots_[(this->write_slot_head_ + index) % WRITE_SLOT_COUNT];
+    }
+    const NeewerWriteSlot &write_slot_(uint8_t index) const {
+      return this->write_slots_[(this->write_slot_head_ + index) % WRITE_SLOT_COUNT];
+    }
+    void push_write_slot_(const NeewerWriteSlot &slot);
+    void complete_write_(esp_gatt_status_t status);
+    void write_lost_(const NeewerWriteSlot &slot, const char *reason);
+    void note_write_latency_(esp_gatt_write_type_t write_type, uint32_t latency_ms);
+    void note_link_loss_(const char *reason);
+    void request_conn_profile_(NeewerConnProfile profile);
+    void update_conn_profile_();
+    void log_stats_();
+    void trace_(NeewerTraceKind kind, const uint8_t *data, uint16_t length) {
+      if (this->packet_trace_)
+        NeewerPacketTrace::record(kind, this->light_id_, data, length);
+    }
+    void note_confirmation_latency_(uint32_t latency_ms);
+    void record_latency_(NeewerLatencyStage stage, uint32_t origin_us) {
+      this->latency_[static_cast<uint8_t>(stage)].record(micros() - origin_us);
+    }
+    void reset_write_queue_();
+    bool mode_frame_pending_() const;
+    void clear_mode_frames_() {
+      this->queued_mode_frame_.clear();
+      this->acked_mode_frame_.clear();
+    }
+    bool is_command_pending_(NeewerCommandClass command_class) const {
+      return this->command_queue_.is_pending(command_class);
+    }
     bool register_for_notifications_(esp_gatt_if_t gattc_if);
+    bool enable_notifications_(esp_gatt_if_t gattc_if);
+    void mark_handles_ready_(const char *source);
+    ESPPreferenceObject &get_handle_cache_pref_();
+    void try_cached_handles_(esp_gatt_if_t gattc_if);
+    void save_handle_cache_();
+    void check_cached_handles_();
     void reset_notification_state_();
     virtual void status_notifications_ready_() {}
     virtual void status_notifications_lost_() {}
-    virtual void handle_status_notification_(const uint8_t *data, uint16_t length) {}
+    virtual void write_failed_(NeewerCommandClass command_class) {}
+    virtual void write_acked_(NeewerCommandClass command_class, const NeewerPacket &packet) {}
+    // Called when a frame is handed to the stack, after waiting in the queue.
+    virtual void frame_sent_(NeewerCommandClass command_class) {}
+    // Called once handles are resolved on a new connection.
+    virtual void connection_ready_() {}
+    virtual void handle_status_frame_(const NeewerPacket &frame) {}
 
     bool require_response_;
     espbt::ESPBTUUID service_uuid_;
     espbt::ESPBTUUID char_uuid_;
     espbt::ESPBTUUID notify_char_uuid_;
     espbt::ESPBTUUID cccd_uuid_ = espbt::ESPBTUUID::from_uint16(0x2902);
+    // Handles are resolved once service discovery completes and cleared on disconnect.
+    uint16_t write_handle_ = 0;
     uint16_t notify_handle_ = 0;
     uint16_t notify_cccd_handle_ = 0;
     bool notify_registered_ = false;
-    espbt::ClientState client_state_;
+    bool handles_ready_ = false;
+    bool cache_validating_ = false;
+    ESPPreferenceObject handle_cache_pref_;
+    bool handle_cache_pref_ready_ = false;
+    espbt::ClientState client_state_ = espbt::ClientState::IDLE;
+    uint32_t connected_ms_ = 0;
+    bool pooled_ = false;
+    bool link_wanted_ = false;
 
     const char* const TAG = "neewer_ble_output";
 
-    uint8_t *msg_;
-    uint8_t msg_len_;
-    uint8_t *orig_msg_;
-    uint8_t orig_msg_len_;
-    bool command_block_ = false;
+    static uint8_t next_light_id_;
+    static bool local_mtu_set_;
+    uint8_t light_id_ = next_light_id_++;
+    bool packet_trace_ = false;
 
-    const uint8_t command_prefix_ = 0x78;
-    const uint8_t power_prefix_ = 0x81;
-    const uint8_t rgb_prefix_ = 0x86;
-    const uint8_t ctwb_prefix_ = 0x87;
-    const uint8_t effect_prefix_ = 0x88;
+    NeewerPacket msg_;
+    NeewerFrameDecoder decoder_;
+
+    NeewerCommandQueue command_queue_;
+    // Writes waiting for their ESP_GATTC_WRITE_CHAR_EVT, oldest first.
+    NeewerWriteSlot write_slots_[WRITE_SLOT_COUNT];
+    uint8_t write_slot_head_ = 0;
+    uint8_t write_slot_count_ = 0;
+    uint32_t last_foreground_ms_ = 0;
+    // Light call behind the frame being queued; 0 stamps frames at queue time.
+    uint32_t frame_origin_us_ = 0;
+    // Ack of the last user frame, until a status read sent after it confirms it.
+    uint32_t confirm_acked_us_ = 0;
+    NeewerLatencyHistogram latency_[LATENCY_STAGE_COUNT];
+    uint32_t last_queued_sequence_ = 0;
+    uint32_t acked_sequence_ = 0;
+    uint32_t acked_us_ = 0;
+
+    // Byte-identical mode frames are dropped when the light already holds them:
+    // the last one queued while a mode frame is still queued or in flight, the
+    // last one the light acknowledged otherwise. Cleared when the light's state
+    // is unknown (power frame, failed write, disconnect).
+    NeewerPacket queued_mode_frame_;
+    NeewerPacket acked_mode_frame_;
+    NeewerCommandClass mode_frame_class_ = NeewerCommandClass::HSI;
+    uint32_t suppressed_writes_ = 0;
+
+    NeewerConnParams active_conn_params_;
+    NeewerConnParams idle_conn_params_;
+    uint32_t idle_after_ms_ = 10000;
+    NeewerConnProfile conn_profile_ = NeewerConnProfile::NONE;
+    uint32_t last_activity_ms_ = 0;
+    uint16_t mtu_ = 0;
+    // What the light actually granted, read back from the stack.
+    uint16_t granted_mtu_ = 0;
+    uint16_t granted_interval_ = 0;
+    uint16_t granted_latency_ = 0;
+    uint16_t granted_timeout_ = 0;
+
+    NeewerLinkStats stats_;
+    uint32_t stats_interval_ms_ = 0;
+    uint32_t last_stats_ms_ = 0;
+
+    // Adaptive write-without-response state (only used when require_response_ is off).
+    bool fast_path_degraded_ = false;
+    uint32_t fast_path_degraded_ms_ = 0;
+    uint8_t recent_losses_ = 0;
+    uint32_t loss_window_start_ms_ = 0;
+    uint32_t ack_latency_avg_ms_ = 0;
+    // Write-without-response completion time: recent (weight 1/4) and long-run (1/16).
+    uint32_t no_rsp_latency_avg_ms_ = 0;
+    uint32_t no_rsp_latency_base_ms_ = 0;
+    uint32_t confirm_latency_avg_ms_ = 0;
 
 };
 
@@ -118,75 +420,128 @@ class NeewerRGBCTLightOutput : public rgbct::RGBCTLightOutput, public NeewerBLEO
     NeewerRGBCTLightOutput();
 
     void dump_config() override;
-    void rgb_to_hsb(float red, float green, float blue, int *hue, uint8_t *saturation, uint8_t *brightness);
     void setup_state(light_ns::LightState *state) override;
-    void set_kelvin_range(float min_kelvin, float max_kelvin) {
-      this->kelvin_min_ = min_kelvin;
-      this->kelvin_max_ = max_kelvin;
-    }
-    void set_supports_green_magenta(bool enabled) { this->supports_gm_ = enabled; }
     void set_green_magenta_bias(float bias) {
       this->green_magenta_bias_ = clamp(bias, -50.0f, 50.0f);
     }
-    bool activate_scene(uint8_t scene_id);
+    void set_max_frame_rate(float frames_per_second) {
+      this->min_frame_interval_ms_ = static_cast<uint32_t>(1000.0f / frames_per_second);
+    }
+    void set_status_verify_delay(uint32_t delay_ms) { this->verify_delay_ms_ = delay_ms; }
+    void set_status_poll_interval(uint32_t interval_ms) { this->poll_interval_ms_ = interval_ms; }
+    void set_track_channel(bool track) { this->track_channel_ = track; }
+    // A brightness above 0 goes into the scene's brightness bytes; 0 keeps the
+    // light's current level.
+    bool activate_scene(uint8_t scene_id, float brightness = 0.0f);
+
+    // Used by neewerlight_group to encode a target once and fan it out.
+    NeewerCommandClass encode_target(NeewerLightTarget *target);
+    const NeewerPacket &get_encoded_frame() const { return this->msg_; }
+    uint32_t apply_target(const NeewerLightTarget &target, const NeewerPacket &frame, NeewerCommandClass frame_class,
+                          NeewerPriority priority = NeewerPriority::USER);
+    bool shares_encoding_with(const NeewerRGBCTLightOutput &other) const;
+
+    // Used by NeewerKeyframeLightEffect to compile its frames: snaps and encodes a
+    // target into `packet`, leaving the light's state and stats alone.
+    NeewerCommandClass encode_frame(NeewerLightTarget *target, NeewerPacket *packet) const;
+    uint32_t get_min_frame_interval() const { return this->min_frame_interval_ms_; }
+    float normalize_color_temperature(float mireds) const;
+
+    // Used by neewerlight_pool: the light is in the middle of something and must
+    // not be disconnected to make room for another one.
+    bool holds_link() const;
 
   protected:
-    float old_red_ = 0.0;
-    float old_green_ = 0.0;
-    float old_blue_ = 0.0;
-    float old_white_brightness_ = 0.0;
-    float old_color_temperature_ = 0.0;
     bool light_on_ = false;
     uint8_t channel_id_ = 0;
+    bool channel_known_ = false;
     bool awaiting_power_status_ = false;
     bool awaiting_channel_status_ = false;
-    bool status_query_active_ = false;
+    bool verify_pending_ = false;
+    uint8_t verify_retries_ = 0;
+    uint32_t verify_delay_ms_ = 1000;
+    uint32_t poll_interval_ms_ = 0;
+    uint32_t last_poll_ms_ = 0;
+    bool track_channel_ = false;
     uint32_t last_power_request_ms_ = 0;
+    uint32_t power_request_sent_us_ = 0;
     uint32_t last_channel_request_ms_ = 0;
     static const uint32_t STATUS_TIMEOUT_MS = 2000;
+    static const uint32_t STATUS_RETRY_MS = 250;
+    static const uint8_t STATUS_MAX_RETRIES = 3;
     bool initial_status_requested_ = false;
-    float kelvin_min_ = 3200.0f;
-    float kelvin_max_ = 5600.0f;
-    bool supports_gm_ = false;
     float green_magenta_bias_ = 0.0f;
     uint16_t last_hue_degrees_ = 0;
     uint8_t last_saturation_percent_ = 100;
     float last_rgb_brightness_fraction_ = 0.0f;
     light_ns::LightState *light_state_ = nullptr;
+    NeewerLightTarget pending_target_;
+    uint32_t pending_call_us_ = 0;
+
+    // Desired state survives a disconnect; confirmed state is what the light last
+    // acknowledged or reported. A reconnect sends only the difference.
+    bool has_desired_ = false;
+    bool desired_on_ = false;
+    NeewerPacket desired_frame_;
+    // The snapped target behind it; scenes take their brightness and CCT from here.
+    NeewerLightTarget desired_target_;
+    float scene_brightness_ = 0.0f;
+    NeewerCommandClass desired_frame_class_ = NeewerCommandClass::HSI;
+    NeewerPowerState confirmed_power_ = NeewerPowerState::UNKNOWN;
+    NeewerPacket confirmed_frame_;
+    bool resync_active_ = false;
+    uint32_t resync_sequence_ = 0;
+    uint8_t resync_frames_ = 0;
+    bool frame_pending_ = false;
+    uint32_t last_frame_ms_ = 0;
+    uint32_t min_frame_interval_ms_ = 100;
 
     const char* const TAG = "neewer_rgbct_light_output";
 
-    bool did_rgb_change(float red, float green, float blue);
     void schedule_initial_status_refresh_();
     void loop() override;
-    bool did_ctwb_change(float color_temperature, float white_brightness);
-    bool did_only_wb_change(float color_temperature, float white_brightness);
     float normalized_ct_to_kelvin_(float normalized_ct) const;
-    void prepare_ctwb_msg(float color_temperature, float white_brightness);
-    void prepare_rgb_msg(float red, float green, float blue);
-    void prepare_wb_msg(float white_brightness);
-    void prepare_power_msg_(bool power_on);
-    void send_power_command_(bool power_on);
+    // Model-specific encoders, implemented by NeewerModelLightOutput<Model>.
+    virtual void prepare_ctwb_msg(float color_temperature, float white_brightness, NeewerPacket *packet) const = 0;
+    virtual void prepare_rgb_msg(float red, float green, float blue, NeewerPacket *packet) const = 0;
+    virtual void prepare_power_msg_(bool power_on) = 0;
+    virtual const NeewerSceneDefinition *prepare_scene_msg_(uint8_t scene_id) = 0;
+    virtual void snap_color_temperature_(NeewerLightTarget *target) const = 0;
+    virtual const char *model_name_() const = 0;
+    virtual bool addressed_frames_() const = 0;
+    bool send_power_command_(bool power_on);
     void prepare_status_msg_(uint8_t request_tag);
     void request_power_status_(bool force = false);
     void request_channel_status_(bool force = false);
     void request_status_refresh_(bool include_channel);
-    void handle_status_notification_(const uint8_t *data, uint16_t length) override;
+    void handle_status_frame_(const NeewerPacket &frame) override;
     void status_notifications_ready_() override;
     void status_notifications_lost_() override;
-    void handle_power_status_response_(uint8_t raw_state);
-    void handle_channel_status_response_(uint8_t channel);
+    void write_failed_(NeewerCommandClass command_class) override;
+    void write_acked_(NeewerCommandClass command_class, const NeewerPacket &packet) override;
+    void frame_sent_(NeewerCommandClass command_class) override;
+    void connection_ready_() override;
+    void finish_resync_();
+    void schedule_verification_();
+    void run_verification_();
+    void verification_failed_(const char *reason);
+    void handle_power_status_response_(const uint8_t *payload, uint8_t length);
+    void handle_channel_status_response_(const uint8_t *payload, uint8_t length);
+
+    using StatusHandler = void (NeewerRGBCTLightOutput::*)(const uint8_t *payload, uint8_t length);
+    static const uint8_t STATUS_TAG_LIMIT = 3;  // one past the highest notify tag handled
+    static const StatusHandler STATUS_HANDLERS[STATUS_TAG_LIMIT];
     void check_status_timeouts_();
-    bool build_scene_message_(const NeewerSceneDefinition &definition);
+    void fill_scene_bytes_(uint8_t *live, uint8_t cct_byte) const;
     uint8_t current_brightness_byte_(bool secondary = false) const;
-    uint8_t convert_kelvin_to_scene_byte_(float kelvin) const;
     uint16_t current_hue_degrees_() const;
     uint8_t current_saturation_percent_() const;
     uint8_t gm_bias_byte_() const;
     uint8_t default_speed_byte_() const;
     uint8_t default_sparks_byte_() const;
     uint8_t default_color_byte_() const;
-    void set_old_rgbct(float red, float green, float blue, float color_temperature, float white_brightness);
+    void emit_pending_frame_();
+    void snap_to_device_resolution_(NeewerLightTarget *target) const;
     void write_state(light_ns::LightState *state) override;
 };
 
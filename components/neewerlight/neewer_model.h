@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "neewer_light_output.h"
+#include "neewer_protocol.h"
+
+#ifdef USE_ESP32
+
+// The light output for one model. The template argument is a traits struct that
+// light.py generates from models.json for each model a configuration uses, so the
+// encoders below are only instantiated for those models and every model property
+// is a compile-time constant. A traits struct provides:
+//
+//   NAME                          the `model:` key
+//   KELVIN_MIN, KELVIN_MAX        CCT range
+//   CCT_IN_KELVIN                 CCT byte is kelvin / 100, else 1/24 of the mired range
+//   HAS_GM                        a green/magenta byte follows the CCT byte
+//   CCT_TRAILER, _SIZE            fixed bytes closing a CCT frame (may be nullptr, 0)
+//   MAC_PREFIXED                  Infinity framing: outer tag, MAC, classic tag as subtag
+//   SCENES, SCENE_COUNT           FX layouts indexed by scene id - 1 (may be nullptr, 0)
+//   SCENE_CCT_MIN, SCENE_CCT_MAX  CCT byte scale inside scene frames
+//   MAX_FRAME_SIZE                longest frame the model emits
+
+namespace esphome {
+namespace neewerlight {
+
+template<typename... Params>
+constexpr NeewerSceneDefinition neewer_scene(uint8_t scene_id, const char *name, Params... params) {
+  return NeewerSceneDefinition{
+      scene_id,
+      name,
+      static_cast<uint8_t>(sizeof...(Params)),
+      {params...},
+      {COMMAND_PREFIX, FX_SUBTAG, static_cast<uint8_t>(1 + sizeof...(Params)), scene_id},
+      static_cast<uint8_t>(COMMAND_PREFIX + FX_SUBTAG + 1 + sizeof...(Params) + scene_id),
+  };
+}
+
+constexpr bool neewer_scenes_indexed_by_id(const NeewerSceneDefinition *scenes, uint8_t count, uint8_t index = 0) {
+  return index >= count || (scenes[index].scene_id == index + 1 && neewer_scenes_indexed_by_id(scenes, count, index + 1));
+}
+
+// overhead: every byte of a scene frame except the parameters.
+constexpr bool neewer_scenes_fit(const NeewerSceneDefinition *scenes, uint8_t count, uint8_t overhead,
+                                 uint8_t max_size, uint8_t index = 0) {
+  return index >= count || (overhead + scenes[index].param_count <= max_size &&
+                            neewer_scenes_fit(scenes, count, overhead, max_size, index + 1));
+}
+
+// Header, scene id and checksum; addressed frames add the MAC and the FX subtag.
+static const uint8_t CLASSIC_SCENE_OVERHEAD = SCENE_HEADER_SIZE + 1;
+static const uint8_t ADDRESSED_SCENE_OVERHEAD = FRAME_HEADER_SIZE + MAC_ADDRESS_SIZE + 2 + 1;
+
+template<typename Model> class NeewerModelLightOutput : public NeewerRGBCTLightOutput {
+  public:
+    static_assert(Model::MAX_FRAME_SIZE <= MSG_MAX_SIZE, "Model frames must fit in a NeewerPacket");
+    static_assert(neewer_scenes_indexed_by_id(Model::SCENES, Model::SCENE_COUNT),
+                  "Model scenes must be ordered by scene id, starting at 1");
+    static_assert(neewer_scenes_fit(Model::SCENES, Model::SCENE_COUNT,
+                                    Model::MAC_PREFIXED ? ADDRESSED_SCENE_OVERHEAD : CLASSIC_SCENE_OVERHEAD,
+                                    Model::MAX_FRAME_SIZE),
+                  "A scene frame does not fit in the model's MAX_FRAME_SIZE");
+
+    NeewerModelLightOutput() {
+      this->set_cold_white_temperature(1000000.0f / Model::KELVIN_MAX);
+      this->set_warm_white_temperature(1000000.0f / Model::KELVIN_MIN);
+    }
+
+  protected:
+    void prepare_ctwb_msg(float color_temperature, float white_brightness, NeewerPacket *packet) const override;
+    void prepare_rgb_msg(float red, float green, float blue, NeewerPacket *packet) const override;
+    void prepare_power_msg_(bool power_on) override;
+    const NeewerSceneDefinition *prepare_scene_msg_(uint8_t scene_id) override;
+    void snap_color_temperature_(NeewerLightTarget *target) const override;
+    const char *model_name_() const override { return Model::NAME; }
+    bool addressed_frames_() const override { return Model::MAC_PREFIXED; }
+    void begin_frame_(NeewerPacket *packet, uint8_t infinity_tag, uint8_t tag) const;
+    uint8_t cct_byte_(float normalized_ct) const;
+    uint8_t scene_cct_byte_(float normalized_ct) const;
+};
+
+// Classic frames start with the command tag. Infinity frames put an outer tag and
+// the light's MAC address first, and carry the classic tag as a subtag.
+template<typename Model>
+void NeewerModelLightOutput<Model>::begin_frame_(NeewerPacket *packet, uint8_t infinity_tag, uint8_t tag) const {
+  if (!Model::MAC_PREFIXED) {
+    packet->begin(tag);
+    return;
+  }
+  packet->begin(infinity_tag);
+  const uint64_t address = this->parent_->get_address();
+  for (int shift = 8 * (MAC_ADDRESS_SIZE - 1); shift >= 0; shift -= 8)
+    packet->append(static_cast<uint8_t>(address >> shift));
+  packet->append(tag);
+}
+
+template<typename Model> uint8_t NeewerModelLightOutput<Model>::cct_byte_(float normalized_ct) const {
+  if (!Model::CCT_IN_KELVIN)
+    return static_cast<uint8_t>(roundf(fabsf((normalized_ct * 24.0f) - 56.0f)));
+  const float kelvin_min = Model::KELVIN_MIN;
+  const float kelvin_max = Model::KELVIN_MAX;
+  const float kelvin = clamp(this->normalized_ct_to_kelvin_(normalized_ct), kelvin_min, kelvin_max);
+  return static_cast<uint8_t>(roundf(kelvin / 100.0f));
+}
+
+// Scene frames take CCT on their own byte scale across the model's range.
+template<typename Model> uint8_t NeewerModelLightOutput<Model>::scene_cct_byte_(float normalized_ct) const {
+  const float kelvin_min = Model::KELVIN_MIN;
+  const float kelvin_max = Model::KELVIN_MAX;
+  float kelvin = this->normalized_ct_to_kelvin_(normalized_ct);
+  if (kelvin <= 0.0f)
+    kelvin = (kelvin_min + kelvin_max) / 2.0f;
+  const float normalized = (clamp(kelvin, kelvin_min, kelvin_max) - kelvin_min) / (kelvin_max - kelvin_min);
+  const int byte_min = Model::SCENE_CCT_MIN;
+  const int byte_max = Model::SCENE_CCT_MAX;
+  return static_cast<uint8_t>(
+      clamp(static_cast<int>(roundf(byte_min + normalized * (byte_max - byte_min))), byte_min, byte_max));
+}
+
+template<typename Model>
+void NeewerModelLightOutput<Model>::prepare_ctwb_msg(float color_temperature, float white_brightness,
+                                                     NeewerPacket *packet) const {
+  const uint8_t wb = static_cast<uint8_t>(roundf(clamp(white_brightness, 0.0f, 1.0f) * 100.0f));
+  const uint8_t ct_byte = this->cct_byte_(color_temperature);
+
+  this->begin_frame_(packet, INFINITY_CCT_TAG, CCT_TAG);
+  packet->append(wb);
+  packet->append(ct_byte);
+  if (Model::HAS_GM)
+    packet->append(this->gm_bias_byte_());
+  for (uint8_t i = 0; i < Model::CCT_TRAILER_SIZE; i++)
+    packet->append(Model::CCT_TRAILER[i]);
+  packet->finish();
+
+  ESP_LOGD(TAG, "CT packet (%s, len=%u inc checksum): brr=%u ct_byte=%u, CT(normalized)=%.3f", Model::NAME,
+           packet->size(), wb, ct_byte, color_temperature);
+}
+
+// Surprise, the "RGB" light isn't actually RGB!
+template<typename Model>
+void NeewerModelLightOutput<Model>::prepare_rgb_msg(float red, float green, float blue, NeewerPacket *packet) const {
+  uint16_t hue;
+  uint8_t saturation;
+  uint8_t brightness;
+  neewer_rgb_to_hsi(red, green, blue, &hue, &saturation, &brightness);
+
+  this->begin_frame_(packet, INFINITY_HSI_TAG, HSI_TAG);
+  packet->append_u16_le(hue);  // hue split across two bytes, LSB first
+  packet->append(saturation);  // saturation 0x00 - 0x64
+  packet->append(brightness);  // brightness 0x00 - 0x64
+  packet->finish();
+
+  ESP_LOGV(TAG, "RGB(%.3f,%.3f,%.3f) -> HSI packet: hue=%u sat=%u brr=%u", red, green, blue, hue, saturation,
+           brightness);
+}
+
+template<typename Model> void NeewerModelLightOutput<Model>::prepare_power_msg_(bool power_on) {
+  this->begin_frame_(&this->msg_, INFINITY_POWER_TAG, POWER_TAG);
+  this->msg_.append(power_on ? POWER_ON : POWER_STANDBY);
+  this->msg_.finish();
+}
+
+template<typename Model>
+const NeewerSceneDefinition *NeewerModelLightOutput<Model>::prepare_scene_msg_(uint8_t scene_id) {
+  if (scene_id == 0 || scene_id > Model::SCENE_COUNT)
+    return nullptr;
+
+  const NeewerSceneDefinition &definition = Model::SCENES[scene_id - 1];
+  uint8_t live[SCENE_BYTE_SOURCE_COUNT];
+  this->fill_scene_bytes_(live, this->scene_cct_byte_(this->desired_target_.color_temperature));
+
+  if (Model::MAC_PREFIXED) {
+    this->begin_frame_(&this->msg_, INFINITY_FX_TAG, FX_SUBTAG);
+    this->msg_.append(definition.scene_id);
+  } else {
+    // The classic header and its partial checksum are precomputed in the table.
+    this->msg_.begin_fixed(definition.header, SCENE_HEADER_SIZE, definition.header_checksum);
+  }
+  for (uint8_t i = 0; i < definition.param_count; i++)
+    this->msg_.append(live[static_cast<uint8_t>(definition.params[i])]);
+  this->msg_.finish();
+  return &definition;
+}
+
+// The CCT byte resolves 1/24 of the mired range on the legacy layout and whole
+// 100 K steps on the kelvin-based ones.
+template<typename Model> void NeewerModelLightOutput<Model>::snap_color_temperature_(NeewerLightTarget *target) const {
+  const float ct = clamp(target->color_temperature, 0.0f, 1.0f);
+  if (!Model::CCT_IN_KELVIN) {
+    target->color_temperature = roundf(ct * 24.0f) / 24.0f;
+    return;
+  }
+  const float mired_span = this->warm_white_temperature_ - this->cold_white_temperature_;
+  if (mired_span <= 0.0f)
+    return;
+  const float kelvin_min = Model::KELVIN_MIN;
+  const float kelvin_max = Model::KELVIN_MAX;
+  const float kelvin = clamp(this->normalized_ct_to_kelvin_(ct), kelvin_min, kelvin_max);
+  const float mired = 1000000.0f / (roundf(kelvin / 100.0f) * 100.0f);
+  target->color_temperature = clamp((mired - this->cold_white_temperature_) / mired_span, 0.0f, 1.0f);
+}
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,72 @@
+#include "neewer_packet_trace.h"
+#include "../../core/hal.h"
+#include "../../core/helpers.h"
+#include "../../core/log.h"
+
+#include <cstring>
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight {
+
+static const char *const TAG = "neewer_packet_trace";
+
+#ifdef USE_NEEWER_PACKET_TRACE
+
+NeewerTraceEntry NeewerPacketTrace::entries_[PACKET_TRACE_ENTRIES];
+uint16_t NeewerPacketTrace::head_ = 0;
+uint32_t NeewerPacketTrace::recorded_ = 0;
+const char *NeewerPacketTrace::addresses_[UINT8_MAX + 1] = {};
+
+void NeewerPacketTrace::record(NeewerTraceKind kind, uint8_t light_id, const uint8_t *data, uint16_t length) {
+  auto &entry = entries_[head_];
+  entry.timestamp_us = micros();
+  entry.light_id = light_id;
+  entry.kind = static_cast<uint8_t>(kind);
+  entry.length = length > UINT8_MAX ? UINT8_MAX : static_cast<uint8_t>(length);
+  memcpy(entry.data, data, length < PACKET_TRACE_FRAME_SIZE ? length : PACKET_TRACE_FRAME_SIZE);
+  head_ = (head_ + 1) % PACKET_TRACE_ENTRIES;
+  recorded_++;
+}
+
+void NeewerPacketTrace::register_light(uint8_t light_id, const char *address) { addresses_[light_id] = address; }
+
+void NeewerPacketTrace::dump() {
+  const uint16_t count = recorded_ < PACKET_TRACE_ENTRIES ? recorded_ : PACKET_TRACE_ENTRIES;
+  ESP_LOGI(TAG, "[nwtrace] begin %u %u", count, recorded_);
+  for (uint16_t i = 0; i <= UINT8_MAX; i++) {
+    if (addresses_[i] != nullptr)
+      ESP_LOGI(TAG, "[nwtrace] light %u %s", i, addresses_[i]);
+  }
+
+  // Oldest entry first; only the used prefix of data[] is printed.
+  const uint16_t start = (head_ + PACKET_TRACE_ENTRIES - count) % PACKET_TRACE_ENTRIES;
+  char line[2 * sizeof(NeewerTraceEntry) + 1];
+  for (uint16_t i = 0; i < count; i++) {
+    const auto &entry = entries_[(start + i) % PACKET_TRACE_ENTRIES];
+    const uint8_t stored = entry.length < PACKET_TRACE_FRAME_SIZE ? entry.length : PACKET_TRACE_FRAME_SIZE;
+    const auto *raw = reinterpret_cast<const uint8_t *>(&entry);
+    const size_t raw_len = sizeof(NeewerTraceEntry) - PACKET_TRACE_FRAME_SIZE + stored;
+    for (size_t j = 0; j < raw_len; j++) {
+      line[2 * j] = format_hex_char(raw[j] >> 4);
+      line[2 * j + 1] = format_hex_char(raw[j] & 0x0F);
+    }
+    line[2 * raw_len] = '\0';
+    ESP_LOGI(TAG, "[nwtrace] %s", line);
+  }
+  ESP_LOGI(TAG, "[nwtrace] end");
+}
+
+#else
+
+void NeewerPacketTrace::record(NeewerTraceKind kind, uint8_t light_id, const uint8_t *data, uint16_t length) {}
+void NeewerPacketTrace::register_light(uint8_t light_id, const char *address) {}
+void NeewerPacketTrace::dump() { ESP_LOGW(TAG, "Packet trace is disabled; set packet_trace: true on a light"); }
+
+#endif  // USE_NEEWER_PACKET_TRACE
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../../core/defines.h"
+#include "../../core/automation.h"
+#include "neewer_protocol.h"
+
+#include <cstdint>
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight {
+
+enum class NeewerTraceKind : uint8_t {
+    TX = 0,   // frame handed to the BLE stack
+    ACK = 1,  // ESP_GATTC_WRITE_CHAR_EVT, data[0] = GATT status
+    RX = 2,   // ESP_GATTC_NOTIFY_EVT payload
+};
+
+static const uint8_t PACKET_TRACE_FRAME_SIZE = MSG_MAX_SIZE;  // longer payloads are truncated
+static const uint16_t PACKET_TRACE_ENTRIES = 128;
+
+// One record in the trace ring. Kept packed so a dump is the raw record bytes
+// in hex; tools/neewer_trace_decode.py turns a dump back into a timeline.
+struct __attribute__((packed)) NeewerTraceEntry {
+    uint32_t timestamp_us;
+    uint8_t light_id;
+    uint8_t kind;
+    uint8_t length;  // original length, may exceed PACKET_TRACE_FRAME_SIZE
+    uint8_t data[PACKET_TRACE_FRAME_SIZE];
+};
+
+// Shared in-RAM ring of TX/ACK/RX frames for every traced light. Recording is a
+// timestamp and a memcpy; formatting only happens in dump().
+class NeewerPacketTrace {
+ public:
+    static void record(NeewerTraceKind kind, uint8_t light_id, const uint8_t *data, uint16_t length);
+    static void register_light(uint8_t light_id, const char *address);
+    static void dump();
+
+ protected:
+#ifdef USE_NEEWER_PACKET_TRACE
+    static NeewerTraceEntry entries_[PACKET_TRACE_ENTRIES];
+    static uint16_t head_;
+    static uint32_t recorded_;
+    static const char *addresses_[UINT8_MAX + 1];
+#endif
+};
+
+template<typename... Ts> class DumpPacketTraceAction : public Action<Ts...> {
+ public:
+    void play(Ts... x) override { NeewerPacketTrace::dump(); }
+};
+
+}  // namespace neewerlight
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Neewer BLE wire format, kept free of ESPHome/ESP-IDF dependencies so frames can
+// be built and checked off-device (e.g. by a simulated light on a Linux host).
+
+namespace esphome {
+namespace neewerlight {
+
+static const uint8_t MSG_MAX_SIZE = 20;  // capacity of a NeewerPacket in bytes, checksum included.
+static const uint8_t COMMAND_PREFIX = 0x78;
+static const uint8_t FRAME_HEADER_SIZE = 3;  // prefix, tag, payload length
+
+// Command tags (ESP -> light)
+static const uint8_t POWER_TAG = 0x81;
+static const uint8_t CHANNEL_STATUS_REQUEST_TAG = 0x84;
+static const uint8_t POWER_STATUS_REQUEST_TAG = 0x85;
+static const uint8_t HSI_TAG = 0x86;
+static const uint8_t CCT_TAG = 0x87;
+static const uint8_t FX_SUBTAG = 0x8B;
+
+// Infinity-protocol lights take the same commands wrapped in a MAC-addressed
+// frame: prefix, outer tag, length, 6-byte MAC, then the classic tag as subtag.
+static const uint8_t MAC_ADDRESS_SIZE = 6;
+static const uint8_t INFINITY_POWER_TAG = 0x8D;
+static const uint8_t INFINITY_HSI_TAG = 0x8F;
+static const uint8_t INFINITY_CCT_TAG = 0x90;
+static const uint8_t INFINITY_FX_TAG = 0x91;
+
+// Notify tags (light -> ESP)
+static const uint8_t CHANNEL_STATUS_RESPONSE_TAG = 0x01;
+static const uint8_t POWER_STATUS_RESPONSE_TAG = 0x02;
+
+static const uint8_t POWER_ON = 0x01;
+static const uint8_t POWER_STANDBY = 0x02;
+
+// Byte sum of everything before the checksum, mod 256.
+inline uint8_t neewer_checksum(const uint8_t *data, uint8_t length) {
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < length; i++)
+    sum += data[i];
+  return sum;
+}
+
+// True if data holds exactly one well-formed frame: prefix, a length byte that
+// matches the buffer, and a correct trailing checksum.
+inline bool neewer_frame_valid(const uint8_t *data, uint16_t length) {
+  if (length < FRAME_HEADER_SIZE + 1 || data[0] != COMMAND_PREFIX)
+    return false;
+  if (FRAME_HEADER_SIZE + data[2] + 1 != length)
+    return false;
+  return neewer_checksum(data, length - 1) == data[length - 1];
+}
+
+// Fixed-capacity Neewer frame: prefix, tag, payload length, payload, checksum.
+// Fields are appended in one pass while the checksum (byte sum of everything
+// before it) runs along; finish() fills in the length and appends the checksum.
+class NeewerPacket {
+ public:
+    void begin(uint8_t tag) {
+      this->data_[0] = COMMAND_PREFIX;
+      this->data_[1] = tag;
+      this->data_[2] = 0;
+      this->size_ = FRAME_HEADER_SIZE;
+      this->checksum_ = COMMAND_PREFIX + tag;
+      this->overflow_ = false;
+      this->length_fixed_ = false;
+    }
+    // Start from a precomputed header whose length byte is already final.
+    void begin_fixed(const uint8_t *header, uint8_t size, uint8_t checksum) {
+      memcpy(this->data_, header, size);
+      this->size_ = size;
+      this->checksum_ = checksum;
+      this->overflow_ = false;
+      this->length_fixed_ = true;
+    }
+    void append(uint8_t value) {
+      if (this->size_ >= MSG_MAX_SIZE - 1) {
+        this->overflow_ = true;
+        return;
+      }
+      this->data_[this->size_++] = value;
+      this->checksum_ += value;
+    }
+    void append_u16_le(uint16_t value) {
+      this->append(static_cast<uint8_t>(value & 0xFF));
+      this->append(static_cast<uint8_t>(value >> 8));
+    }
+    bool finish() {
+      if (!this->length_fixed_) {
+        const uint8_t payload_len = this->size_ - FRAME_HEADER_SIZE;
+        this->data_[2] = payload_len;
+        this->checksum_ += payload_len;
+      }
+      this->data_[this->size_++] = this->checksum_;
+      return !this->overflow_;
+    }
+    // Load a complete frame as received from the light.
+    bool assign(const uint8_t *data, uint8_t size) {
+      if (size > MSG_MAX_SIZE)
+        return false;
+      memcpy(this->data_, data, size);
+      this->size_ = size;
+      this->checksum_ = size == 0 ? 0 : data[size - 1];
+      this->overflow_ = false;
+      this->length_fixed_ = true;
+      return true;
+    }
+    void clear() { this->size_ = 0; }
+
+    uint8_t *data() { return this->data_; }
+    const uint8_t *data() const { return this->data_; }
+    uint8_t size() const { return this->size_; }
+    bool empty() const { return this->size_ == 0; }
+    uint8_t tag() const { return this->data_[1]; }
+    bool operator==(const NeewerPacket &other) const {
+      return this->size_ == other.size_ && memcmp(this->data_, other.data_, this->size_) == 0;
+    }
+    bool operator!=(const NeewerPacket &other) const { return !(*this == other); }
+
+ protected:
+    uint8_t data_[MSG_MAX_SIZE];
+    uint8_t size_ = 0;
+    uint8_t checksum_ = 0;
+    bool overflow_ = false;
+    bool length_fixed_ = false;
+};
+
+// Receive-side counters. Checksum failures on frames that are otherwise well
+// formed point at RF corruption; skipped bytes, impossible length bytes and
+// valid frames with unknown tags point at a protocol mismatch.
+struct NeewerDecoderStats {
+    uint32_t frames = 0;
+    uint32_t bad_checksum = 0;
+    uint32_t bad_length = 0;
+    uint32_t skipped_bytes = 0;
+    uint32_t overflows = 0;
+    uint32_t unknown_tags = 0;
+};
+
+static const uint8_t DECODER_BUFFER_SIZE = 64;  // must be a power of two
+static_assert((DECODER_BUFFER_SIZE & (DECODER_BUFFER_SIZE - 1)) == 0, "DECODER_BUFFER_SIZE must be a power of two");
+
+// Incremental decoder for the notify stream. Notifies may carry several frames
+// or only part of one, so bytes go into a small ring and whole frames come out.
+// On a bad length or checksum the decoder drops one byte and hunts for the next
+// prefix, which resynchronises after a lost or corrupted notify.
+class NeewerFrameDecoder {
+ public:
+    // Returns false if old bytes had to be discarded to make room.
+    bool feed(const uint8_t *data, uint16_t length) {
+      bool fit = true;
+      for (uint16_t i = 0; i < length; i++) {
+        if (this->count_ == DECODER_BUFFER_SIZE) {
+          this->drop_(1);
+          this->stats_.overflows++;
+          fit = false;
+        }
+        this->buffer_[(this->head_ + this->count_) & (DECODER_BUFFER_SIZE - 1)] = data[i];
+        this->count_++;
+      }
+      return fit;
+    }
+
+    // Pull the next complete, checksum-valid frame. Returns false when the ring
+    // holds no whole frame yet.
+    bool next(NeewerPacket *frame) {
+      while (this->count_ > 0) {
+        if (this->peek_(0) != COMMAND_PREFIX) {
+          this->drop_(1);
+          this->stats_.skipped_bytes++;
+          continue;
+        }
+        if (this->count_ < FRAME_HEADER_SIZE)
+          return false;
+        const uint16_t size = FRAME_HEADER_SIZE + this->peek_(2) + 1;
+        if (size > MSG_MAX_SIZE) {
+          this->drop_(1);
+          this->stats_.bad_length++;
+          continue;
+        }
+        if (this->count_ < size)
+          return false;
+
+        uint8_t raw[MSG_MAX_SIZE];
+        for (uint8_t i = 0; i < size; i++)
+          raw[i] = this->peek_(i);
+        if (neewer_checksum(raw, size - 1) != raw[size - 1]) {
+          this->drop_(1);
+          this->stats_.bad_checksum++;
+          continue;
+        }
+        this->drop_(size);
+        this->stats_.frames++;
+        return frame->assign(raw, size);
+      }
+      return false;
+    }
+
+    void clear() { this->head_ = this->count_ = 0; }
+    void note_unknown_tag() { this->stats_.unknown_tags++; }
+    const NeewerDecoderStats &get_stats() const { return this->stats_; }
+
+ protected:
+    uint8_t peek_(uint8_t offset) const { return this->buffer_[(this->head_ + offset) & (DECODER_BUFFER_SIZE - 1)]; }
+    void drop_(uint8_t count) {
+      this->head_ = (this->head_ + count) & (DECODER_BUFFER_SIZE - 1);
+      this->count_ -= count;
+    }
+
+    uint8_t buffer_[DECODER_BUFFER_SIZE];
+    uint8_t head_ = 0;
+    uint8_t count_ = 0;
+    NeewerDecoderStats stats_;
+};
+
+}  // namespace neewerlight
+}  // namespace esphome
@@ -0,0 +1,87 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.components.neewerlight import output as nw_output
+from esphome.const import (
+    CONF_ID,
+    CONF_OUTPUT_ID,
+    DEVICE_CLASS_DURATION,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MILLISECOND,
+)
+
+DEPENDENCIES = ["neewerlight"]
+
+CONF_STAGE = "stage"
+CONF_LATENCY_P50 = "latency_p50"
+CONF_LATENCY_P95 = "latency_p95"
+CONF_LATENCY_P99 = "latency_p99"
+CONF_WRITES_PER_SECOND = "writes_per_second"
+CONF_WRITE_FAILURES = "write_failures"
+CONF_STATUS_TIMEOUTS = "status_timeouts"
+
+neewerlight_ns = cg.esphome_ns.namespace("neewerlight")
+NeewerLatencySensor = neewerlight_ns.class_(
+    "NeewerLatencySensor", cg.PollingComponent
+)
+NeewerLatencyStage = neewerlight_ns.enum("NeewerLatencyStage", is_class=True)
+STAGES = {
+    "write": NeewerLatencyStage.WRITE,
+    "ack": NeewerLatencyStage.ACK,
+    "confirm": NeewerLatencyStage.CONFIRM,
+}
+
+_LATENCY_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    accuracy_decimals=1,
+    device_class=DEVICE_CLASS_DURATION,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+_COUNTER_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(NeewerLatencySensor),
+        cv.Required(CONF_OUTPUT_ID): cv.use_id(nw_output.NeewerBLEOutput),
+        cv.Optional(CONF_STAGE, default="ack"): cv.enum(STAGES, lower=True),
+        cv.Optional(CONF_LATENCY_P50): _LATENCY_SCHEMA,
+        cv.Optional(CONF_LATENCY_P95): _LATENCY_SCHEMA,
+        cv.Optional(CONF_LATENCY_P99): _LATENCY_SCHEMA,
+        cv.Optional(CONF_WRITES_PER_SECOND): sensor.sensor_schema(
+            unit_of_measurement="writes/s",
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_WRITE_FAILURES): _COUNTER_SCHEMA,
+        cv.Optional(CONF_STATUS_TIMEOUTS): _COUNTER_SCHEMA,
+    }
+).extend(cv.polling_component_schema("60s"))
+
+SENSORS = {
+    CONF_LATENCY_P50: "set_p50_sensor",
+    CONF_LATENCY_P95: "set_p95_sensor",
+    CONF_LATENCY_P99: "set_p99_sensor",
+    CONF_WRITES_PER_SECOND: "set_writes_per_second_sensor",
+    CONF_WRITE_FAILURES: "set_write_failures_sensor",
+    CONF_STATUS_TIMEOUTS: "set_status_timeouts_sensor",
+}
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    output = await cg.get_variable(config[CONF_OUTPUT_ID])
+    cg.add(var.set_output(output))
+    cg.add(var.set_stage(config[CONF_STAGE]))
+    for key, setter in SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(var, setter)(sens))
@@ -6,6 +6,8 @@ from esphome.const import CONF_ID
 DEPENDENCIES = ["esp32_ble_tracker"]
 CODEOWNERS = ["@litui"]
 
+CONF_REFRESH_INTERVAL = "refresh_interval"
+
 neewerlight_ble_ns = cg.esphome_ns.namespace("neewerlight_ble")
 NeewerLightListener = neewerlight_ble_ns.class_(
     "NeewerLightListener", esp32_ble_tracker.ESPBTDeviceListener
@@ -14,10 +16,14 @@ NeewerLightListener = neewerlight_ble_ns.class_(
 CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.declare_id(NeewerLightListener),
+        cv.Optional(
+            CONF_REFRESH_INTERVAL, default="5min"
+        ): cv.positive_time_period_milliseconds,
     }
 ).extend(esp32_ble_tracker.ESP_BLE_DEVICE_SCHEMA)
 
 
 def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
+    cg.add(var.set_refresh_interval(config[CONF_REFRESH_INTERVAL]))
     yield esp32_ble_tracker.register_ble_device(var, config)
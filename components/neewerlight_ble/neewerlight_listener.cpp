@@ -1,6 +1,9 @@
 #include "neewerlight_listener.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
+#include <cstring>
+
 #ifdef USE_ESP32
 
 namespace esphome {
@@ -8,17 +11,135 @@ namespace neewerlight_ble {
 
 static const char *const TAG = "neewerlight_ble";
 
-bool NeewerLightListener::parse_device(const esp32_ble_tracker::ESPBTDevice &device) {
-  if (device.get_name() == "NEEWER-RGB660") {
-    ESP_LOGI(TAG, "Discovered Neewer RGB660 light: %s (RSSI: %ddBm)", device.address_str().c_str(), device.get_rssi());
-    ESP_LOGD(TAG, "Device details - Name: %s, Address Type: %d", device.get_name().c_str(), device.get_address_type());
-    return true;
-  }
+// AD structure types (Bluetooth Core Supplement, part A).
+static const uint8_t AD_TYPE_INCOMPLETE_UUID128 = 0x06;
+static const uint8_t AD_TYPE_COMPLETE_UUID128 = 0x07;
+static const uint8_t AD_TYPE_SHORT_NAME = 0x08;
+static const uint8_t AD_TYPE_COMPLETE_NAME = 0x09;
+
+// 69400001-B5A3-F393-E0A9-E50E24DCCA99, in the little-endian order it is advertised in.
+static const uint8_t NEEWER_SERVICE_UUID[16] = {0x99, 0xCA, 0xDC, 0x24, 0x0E, 0xE5, 0xA9, 0xE0,
+                                                0x93, 0xF3, 0xA3, 0xB5, 0x01, 0x00, 0x40, 0x69};
 
-  ESP_LOGV(TAG, "Ignoring non-Neewer device: %s (%s)", device.get_name().c_str(), device.address_str().c_str());
+// Advertised names start with one of these.
+static const char *const NAME_PREFIXES[] = {"NEEWER", "NW-"};
+
+// Name fragment -> `model:` option of the neewerlight platform.
+struct NameModel {
+  const char *fragment;
+  const char *model;
+};
+static const NameModel NAME_MODELS[] = {
+    {"RGB660", "rgb660"},
+    {"RGB62", "rgb62"},
+};
+
+static bool starts_with(const uint8_t *name, uint8_t length, const char *prefix) {
+  const size_t prefix_length = strlen(prefix);
+  return length >= prefix_length && memcmp(name, prefix, prefix_length) == 0;
+}
+
+static bool contains(const uint8_t *name, uint8_t length, const char *fragment) {
+  const size_t fragment_length = strlen(fragment);
+  for (size_t i = 0; i + fragment_length <= length; i++) {
+    if (memcmp(name + i, fragment, fragment_length) == 0)
+      return true;
+  }
   return false;
 }
 
+static const char *model_from_name(const uint8_t *name, uint8_t length) {
+  for (const auto &entry : NAME_MODELS) {
+    if (contains(name, length, entry.fragment))
+      return entry.model;
+  }
+  // Newer lights advertise "NW-" and a numeric product code and speak the Infinity protocol.
+  if (length > 3 && starts_with(name, length, "NW-") && name[3] >= '0' && name[3] <= '9')
+    return "infinity";
+  return "unknown";
+}
+
+bool NeewerLightListener::parse_devices(esp_ble_gap_cb_param_t::ble_scan_result_evt_param *advertisements,
+                                        size_t count) {
+  bool found = false;
+  for (size_t i = 0; i < count; i++) {
+    if (this->parse_advertisement_(advertisements[i]))
+      found = true;
+  }
+  return found;
+}
+
+// One pass over at most 62 bytes of advertisement and scan response data, no
+// allocation. Anything that isn't a Neewer light returns false from here.
+bool NeewerLightListener::parse_advertisement_(
+    const esp_ble_gap_cb_param_t::ble_scan_result_evt_param &advertisement) {
+  const uint8_t *data = advertisement.ble_adv;
+  const uint8_t length = advertisement.adv_data_len + advertisement.scan_rsp_len;
+  const uint8_t *name = nullptr;
+  uint8_t name_length = 0;
+  bool matched = false;
+
+  for (uint8_t offset = 0; offset + 1 < length;) {
+    const uint8_t field_length = data[offset];
+    if (field_length == 0 || offset + 1 + field_length > length)
+      break;
+    const uint8_t type = data[offset + 1];
+    const uint8_t *value = data + offset + 2;
+    const uint8_t value_length = field_length - 1;
+    if (type == AD_TYPE_COMPLETE_NAME || type == AD_TYPE_SHORT_NAME) {
+      name = value;
+      name_length = value_length;
+      for (const char *prefix : NAME_PREFIXES) {
+        if (starts_with(value, value_length, prefix))
+          matched = true;
+      }
+    } else if (type == AD_TYPE_COMPLETE_UUID128 || type == AD_TYPE_INCOMPLETE_UUID128) {
+      for (uint8_t uuid = 0; uuid + sizeof(NEEWER_SERVICE_UUID) <= value_length; uuid += sizeof(NEEWER_SERVICE_UUID)) {
+        if (memcmp(value + uuid, NEEWER_SERVICE_UUID, sizeof(NEEWER_SERVICE_UUID)) == 0)
+          matched = true;
+      }
+    }
+    offset += 1 + field_length;
+  }
+  if (!matched)
+    return false;
+
+  const uint8_t *bda = advertisement.bda;
+  uint64_t address = 0;
+  for (uint8_t i = 0; i < 6; i++)
+    address = (address << 8) | bda[i];
+
+  bool inserted;
+  SeenLight *light = this->find_or_insert_(address, &inserted);
+  const uint32_t now = millis();
+  light->last_seen_ms = now;
+  if (!inserted && now - light->last_report_ms < this->refresh_interval_ms_)
+    return true;
+  light->last_report_ms = now;
+
+  const char *model = name != nullptr ? model_from_name(name, name_length) : "unknown";
+  ESP_LOGI(TAG, "%s Neewer light %02X:%02X:%02X:%02X:%02X:%02X: model %s, name \"%.*s\", RSSI %ddBm",
+           inserted ? "Discovered" : "Still seeing", bda[0], bda[1], bda[2], bda[3], bda[4], bda[5], model,
+           name_length, name != nullptr ? reinterpret_cast<const char *>(name) : "", advertisement.rssi);
+  return true;
+}
+
+NeewerLightListener::SeenLight *NeewerLightListener::find_or_insert_(uint64_t address, bool *inserted) {
+  const uint32_t now = millis();
+  SeenLight *victim = &this->seen_[0];
+  for (auto &entry : this->seen_) {
+    if (entry.address == address) {
+      *inserted = false;
+      return &entry;
+    }
+    if (victim->address != 0 && (entry.address == 0 || now - entry.last_seen_ms > now - victim->last_seen_ms))
+      victim = &entry;
+  }
+  *inserted = true;
+  victim->address = address;
+  return victim;
+}
+
 }  // namespace neewerlight_ble
 }  // namespace esphome
 
@@ -8,9 +8,36 @@
 namespace esphome {
 namespace neewerlight_ble {
 
+// Lights remembered at once; when full, the one heard from longest ago is dropped.
+static const uint8_t SEEN_CACHE_SIZE = 16;
+
+// Reports Neewer lights seen by esp32_ble_tracker. Works on the raw scan
+// results, so the tracker doesn't have to build an ESPBTDevice (name string,
+// UUID and manufacturer data vectors) for every advertisement in range. Each
+// light is logged once with its model and RSSI, and again after
+// refresh_interval if it is still advertising.
 class NeewerLightListener : public esp32_ble_tracker::ESPBTDeviceListener {
  public:
-  bool parse_device(const esp32_ble_tracker::ESPBTDevice &device) override;
+  void set_refresh_interval(uint32_t interval_ms) { this->refresh_interval_ms_ = interval_ms; }
+
+  bool parse_device(const esp32_ble_tracker::ESPBTDevice &device) override { return false; }
+  bool parse_devices(esp_ble_gap_cb_param_t::ble_scan_result_evt_param *advertisements, size_t count) override;
+  esp32_ble_tracker::AdvertisementParserType get_advertisement_parser_type() override {
+    return esp32_ble_tracker::AdvertisementParserType::RAW_ADVERTISEMENTS;
+  }
+
+ protected:
+  struct SeenLight {
+    uint64_t address;  // 0 = free slot
+    uint32_t last_seen_ms;
+    uint32_t last_report_ms;
+  };
+
+  bool parse_advertisement_(const esp_ble_gap_cb_param_t::ble_scan_result_evt_param &advertisement);
+  SeenLight *find_or_insert_(uint64_t address, bool *inserted);
+
+  SeenLight seen_[SEEN_CACHE_SIZE]{};
+  uint32_t refresh_interval_ms_ = 300000;
 };
 
 }  // namespace neewerlight_ble
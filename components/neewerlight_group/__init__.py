@@ -0,0 +1 @@
+CODEOWNERS = ["@litui"]
@@ -0,0 +1,79 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+import esphome.final_validate as fv
+from esphome.components import light
+from esphome.components.neewerlight import light as nw_light
+from esphome.const import (
+    CONF_GAMMA_CORRECT,
+    CONF_LIGHT,
+    CONF_NAME,
+    CONF_OUTPUT_ID,
+    CONF_PLATFORM,
+)
+
+CONF_MEMBERS = "members"
+CONF_MAX_FRAME_RATE = "max_frame_rate"
+CONF_STATS_INTERVAL = "stats_interval"
+
+DEPENDENCIES = ["neewerlight"]
+
+neewerlight_group_ns = cg.esphome_ns.namespace("neewerlight_group")
+NeewerGroupLightOutput = neewerlight_group_ns.class_(
+    "NeewerGroupLightOutput", light.LightOutput, cg.Component
+)
+
+CONFIG_SCHEMA = (
+    cv.Schema(
+        {
+            cv.GenerateID(CONF_OUTPUT_ID): cv.declare_id(NeewerGroupLightOutput),
+            cv.Required(CONF_NAME): cv.string,
+            cv.Required(CONF_MEMBERS): cv.All(
+                cv.ensure_list(cv.use_id(nw_light.NeewerRGBCTLightOutput)),
+                cv.Length(min=2),
+            ),
+            cv.Optional(CONF_GAMMA_CORRECT, default=1.0): cv.positive_float,
+            cv.Optional(CONF_MAX_FRAME_RATE, default=10.0): cv.float_range(
+                min=1.0, max=50.0
+            ),
+            cv.Optional(CONF_STATS_INTERVAL): cv.positive_time_period_milliseconds,
+        }
+    )
+    .extend(cv.ENTITY_BASE_SCHEMA)
+    .extend(light.RGB_LIGHT_SCHEMA)
+    .extend(cv.COMPONENT_SCHEMA)
+)
+
+
+def _final_validate(config):
+    # The group offers the colour temperatures all of its members can show, so
+    # members of different models need white ranges that overlap.
+    members = {str(member_id) for member_id in config[CONF_MEMBERS]}
+    ranges = []
+    for other in fv.full_config.get().get(CONF_LIGHT, []):
+        if other.get(CONF_PLATFORM) != "neewerlight" or str(other[CONF_OUTPUT_ID]) not in members:
+            continue
+        cct = nw_light.MODELS[other[nw_light.CONF_MODEL]]["cct"]
+        ranges.append((other[CONF_NAME], cct["kelvin_min"], cct["kelvin_max"]))
+    if ranges and max(r[1] for r in ranges) >= min(r[2] for r in ranges):
+        described = ", ".join(f"'{name}' {low}-{high}K" for name, low, high in ranges)
+        raise cv.Invalid(
+            f"the members' colour temperature ranges don't overlap ({described}); "
+            "a group can only offer temperatures every member can show",
+            path=[CONF_MEMBERS],
+        )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _final_validate
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_OUTPUT_ID])
+    await cg.register_component(var, config)
+    for member_id in config[CONF_MEMBERS]:
+        member = await cg.get_variable(member_id)
+        cg.add(var.add_member(member))
+    cg.add(var.set_max_frame_rate(config[CONF_MAX_FRAME_RATE]))
+    if CONF_STATS_INTERVAL in config:
+        cg.add(var.set_stats_interval(config[CONF_STATS_INTERVAL]))
+    await light.register_light(var, config)
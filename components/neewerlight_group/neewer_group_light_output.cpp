@@ -0,0 +1,169 @@
+#include "neewer_group_light_output.h"
+
+#ifdef USE_ESP32
+
+#include <algorithm>
+#include <cstdio>
+
+#include "../../core/hal.h"
+
+namespace esphome {
+namespace neewerlight_group {
+
+// Members may be different models with different white ranges (see
+// emit_pending_frame_), so the group only offers the colour temperatures every
+// member can show. light.py rejects groups whose ranges don't overlap.
+light_ns::LightTraits NeewerGroupLightOutput::get_traits() {
+  auto traits = this->members_.front().output->get_traits();
+  for (const auto &member : this->members_) {
+    const auto member_traits = member.output->get_traits();
+    traits.set_min_mireds(std::max(traits.get_min_mireds(), member_traits.get_min_mireds()));
+    traits.set_max_mireds(std::min(traits.get_max_mireds(), member_traits.get_max_mireds()));
+  }
+  return traits;
+}
+
+void NeewerGroupLightOutput::dump_config() {
+  ESP_LOGCONFIG(TAG, "Neewer Group Light Output:");
+  ESP_LOGCONFIG(TAG, "  Max frame rate     : %.1f fps", 1000.0f / this->min_frame_interval_ms_);
+  for (const auto &member : this->members_) {
+    ESP_LOGCONFIG(TAG, "  Member             : light %u (%s)", member.output->get_light_id(),
+                  member.output->parent()->address_str());
+  }
+}
+
+// Same pacing as a single light: transition ticks are coalesced to max_frame_rate
+// and loop() flushes the final target.
+void NeewerGroupLightOutput::write_state(light_ns::LightState *state) {
+  auto &target = this->pending_target_;
+  state->current_values_as_rgbct(&target.red, &target.green, &target.blue, &target.color_temperature,
+                                 &target.white_brightness);
+  target.on = state->current_values.is_on();
+  this->frame_pending_ = true;
+
+  if (state->is_transformer_active() && millis() - this->last_frame_ms_ < this->min_frame_interval_ms_)
+    return;
+  this->emit_pending_frame_();
+}
+
+void NeewerGroupLightOutput::loop() {
+  if (this->frame_pending_ && millis() - this->last_frame_ms_ >= this->min_frame_interval_ms_)
+    this->emit_pending_frame_();
+  if (this->fanout_active_)
+    this->check_fanout_();
+  if (this->stats_interval_ms_ != 0 && millis() - this->last_stats_ms_ >= this->stats_interval_ms_) {
+    this->last_stats_ms_ = millis();
+    this->log_stats_();
+  }
+}
+
+// Encode the target with the first member, then hand the same frame to every
+// member that encodes identically. Only members that differ (another kelvin range
+// or G/M bias, or a different current mode) pay for their own encode. Each member
+// queues and transmits straight away; nobody waits for another light's ack.
+void NeewerGroupLightOutput::emit_pending_frame_() {
+  this->frame_pending_ = false;
+  this->last_frame_ms_ = millis();
+  if (this->fanout_active_)
+    ESP_LOGV(TAG, "Previous fan-out superseded before every member acked");
+
+  NeewerRGBCTLightOutput *lead = this->members_.front().output;
+  NeewerLightTarget lead_target = this->pending_target_;
+  const NeewerCommandClass lead_class = lead->encode_target(&lead_target);
+  const NeewerPacket lead_frame = lead->get_encoded_frame();
+  this->encodes_++;
+
+  // Decide who shares the lead frame before anyone applies it; applying moves
+  // the lead's current mode.
+  for (auto &member : this->members_)
+    member.shares_frame = member.output == lead || member.output->shares_encoding_with(*lead);
+
+  this->fanout_start_us_ = micros();
+  this->fanout_start_ms_ = millis();
+  bool any_sent = false;
+  for (auto &member : this->members_) {
+    auto *output = member.output;
+    if (member.shares_frame) {
+      member.sequence = output->apply_target(lead_target, lead_frame, lead_class);
+    } else {
+      NeewerLightTarget target = this->pending_target_;
+      const NeewerCommandClass frame_class = output->encode_target(&target);
+      this->encodes_++;
+      member.sequence = output->apply_target(target, output->get_encoded_frame(), frame_class);
+    }
+    member.acked = member.sequence == 0;
+    member.latency_us = 0;
+    any_sent |= member.sequence != 0;
+  }
+  this->fanout_active_ = any_sent;
+}
+
+void NeewerGroupLightOutput::check_fanout_() {
+  bool pending = false;
+  for (auto &member : this->members_) {
+    if (member.acked)
+      continue;
+    if (member.output->is_acknowledged(member.sequence)) {
+      member.acked = true;
+      member.latency_us = member.output->get_acked_us() - this->fanout_start_us_;
+      member.latency_avg_us = (member.latency_avg_us * 3 + member.latency_us) / 4;
+    } else {
+      pending = true;
+    }
+  }
+  if (pending && millis() - this->fanout_start_ms_ < FANOUT_TIMEOUT_MS)
+    return;
+  this->finish_fanout_();
+}
+
+// Skew is the spread between the first and the last member to acknowledge the
+// frame; members that had nothing to send don't count.
+void NeewerGroupLightOutput::finish_fanout_() {
+  this->fanout_active_ = false;
+  uint32_t first_us = UINT32_MAX;
+  uint32_t last_us = 0;
+  uint8_t acked = 0;
+  for (auto &member : this->members_) {
+    if (member.sequence == 0)
+      continue;
+    if (!member.acked) {
+      member.missed++;
+      ESP_LOGD(TAG, "Light %u did not ack the group frame within %ums", member.output->get_light_id(),
+               FANOUT_TIMEOUT_MS);
+      continue;
+    }
+    ESP_LOGV(TAG, "Light %u acked after %.1fms", member.output->get_light_id(), member.latency_us / 1000.0f);
+    first_us = std::min(first_us, member.latency_us);
+    last_us = std::max(last_us, member.latency_us);
+    acked++;
+  }
+  if (acked == 0)
+    return;
+
+  this->fanouts_++;
+  this->last_skew_us_ = last_us - first_us;
+  this->skew_avg_us_ = (this->skew_avg_us_ * 3 + this->last_skew_us_) / 4;
+  ESP_LOGD(TAG, "Fan-out to %u lights: first ack %.1fms, last %.1fms, skew %.1fms (avg %.1fms)", acked,
+           first_us / 1000.0f, last_us / 1000.0f, this->last_skew_us_ / 1000.0f, this->skew_avg_us_ / 1000.0f);
+}
+
+void NeewerGroupLightOutput::log_stats_() {
+  char members[256];
+  size_t used = 0;
+  for (const auto &member : this->members_) {
+    const int written =
+        snprintf(members + used, sizeof(members) - used, "%s{\"light\":%u,\"ack_ms_avg\":%.1f,\"missed\":%u}",
+                 used == 0 ? "" : ",", member.output->get_light_id(), member.latency_avg_us / 1000.0f, member.missed);
+    if (written < 0 || static_cast<size_t>(written) >= sizeof(members) - used)
+      break;
+    used += written;
+  }
+  members[used] = '\0';
+  ESP_LOGI(TAG, "[nwgroup] {\"fanouts\":%u,\"encodes\":%u,\"skew_ms_avg\":%.1f,\"skew_ms_last\":%.1f,\"members\":[%s]}",
+           this->fanouts_, this->encodes_, this->skew_avg_us_ / 1000.0f, this->last_skew_us_ / 1000.0f, members);
+}
+
+}  // namespace neewerlight_group
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#include "../light/light_state.h"
+#include "../../core/component.h"
+#include "../../core/log.h"
+#include "../neewerlight/neewer_light_output.h"
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight_group {
+
+namespace light_ns = ::esphome::light;
+using neewerlight::NeewerCommandClass;
+using neewerlight::NeewerLightTarget;
+using neewerlight::NeewerPacket;
+using neewerlight::NeewerRGBCTLightOutput;
+
+// How long a fan-out waits for every member's ack before the stragglers are
+// counted as missed.
+static const uint32_t FANOUT_TIMEOUT_MS = 2000;
+
+// One light entity driving several Neewer lights, each on its own BLE connection.
+// A target is encoded once and the frame is queued on every member in the same
+// pass, so the writes go out together instead of one light call after another.
+// Member entities keep their own state and don't follow the group.
+class NeewerGroupLightOutput : public light_ns::LightOutput, public Component {
+ public:
+    void add_member(NeewerRGBCTLightOutput *member) { this->members_.push_back(Member{member}); }
+    void set_max_frame_rate(float frames_per_second) {
+      this->min_frame_interval_ms_ = static_cast<uint32_t>(1000.0f / frames_per_second);
+    }
+    void set_stats_interval(uint32_t interval_ms) { this->stats_interval_ms_ = interval_ms; }
+
+    light_ns::LightTraits get_traits() override;
+    void write_state(light_ns::LightState *state) override;
+    void loop() override;
+    void dump_config() override;
+    float get_setup_priority() const override { return setup_priority::DATA; }
+    uint32_t get_skew_avg_us() const { return this->skew_avg_us_; }
+
+ protected:
+    struct Member {
+      NeewerRGBCTLightOutput *output;
+      // Frame the current fan-out waits on; 0 once acked or when nothing was sent.
+      uint32_t sequence = 0;
+      uint32_t latency_us = 0;
+      uint32_t latency_avg_us = 0;
+      uint32_t missed = 0;
+      bool acked = false;
+      bool shares_frame = false;
+    };
+
+    void emit_pending_frame_();
+    void check_fanout_();
+    void finish_fanout_();
+    void log_stats_();
+
+    std::vector<Member> members_;
+    NeewerLightTarget pending_target_;
+    bool frame_pending_ = false;
+    uint32_t last_frame_ms_ = 0;
+    uint32_t min_frame_interval_ms_ = 100;
+
+    bool fanout_active_ = false;
+    uint32_t fanout_start_us_ = 0;
+    uint32_t fanout_start_ms_ = 0;
+    uint32_t fanouts_ = 0;
+    uint32_t encodes_ = 0;
+    uint32_t last_skew_us_ = 0;
+    uint32_t skew_avg_us_ = 0;
+
+    uint32_t stats_interval_ms_ = 0;
+    uint32_t last_stats_ms_ = 0;
+
+    const char* const TAG = "neewer_group_light_output";
+};
+
+}  // namespace neewerlight_group
+}  // namespace esphome
+
+#endif  // USE_ESP32
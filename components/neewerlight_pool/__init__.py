@@ -0,0 +1,55 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components.neewerlight import light as nw_light
+from esphome.const import CONF_ID
+
+CODEOWNERS = ["@litui"]
+DEPENDENCIES = ["neewerlight"]
+
+CONF_LIGHTS = "lights"
+CONF_MAX_CONNECTIONS = "max_connections"
+CONF_CONNECT_TIMEOUT = "connect_timeout"
+CONF_STATS_INTERVAL = "stats_interval"
+
+neewerlight_pool_ns = cg.esphome_ns.namespace("neewerlight_pool")
+NeewerConnectionPool = neewerlight_pool_ns.class_("NeewerConnectionPool", cg.Component)
+
+
+def _validate_pool(config):
+    if config[CONF_MAX_CONNECTIONS] >= len(config[CONF_LIGHTS]):
+        raise cv.Invalid(
+            f"{CONF_MAX_CONNECTIONS} ({config[CONF_MAX_CONNECTIONS]}) leaves room for every light; "
+            "a pool is only needed for more lights than connections"
+        )
+    return config
+
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(NeewerConnectionPool),
+            cv.Optional(CONF_MAX_CONNECTIONS, default=3): cv.int_range(min=1, max=9),
+            cv.Optional(
+                CONF_CONNECT_TIMEOUT, default="20s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_STATS_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Required(CONF_LIGHTS): cv.All(
+                cv.ensure_list(cv.use_id(nw_light.NeewerRGBCTLightOutput)),
+                cv.Length(min=2),
+            ),
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    _validate_pool,
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    cg.add(var.set_max_connections(config[CONF_MAX_CONNECTIONS]))
+    cg.add(var.set_connect_timeout(config[CONF_CONNECT_TIMEOUT]))
+    if CONF_STATS_INTERVAL in config:
+        cg.add(var.set_stats_interval(config[CONF_STATS_INTERVAL]))
+    for light_id in config[CONF_LIGHTS]:
+        output = await cg.get_variable(light_id)
+        cg.add(var.add_light(output))
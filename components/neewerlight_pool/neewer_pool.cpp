@@ -0,0 +1,190 @@
+#include "neewer_pool.h"
+
+#ifdef USE_ESP32
+
+#include <algorithm>
+
+#include "../../core/hal.h"
+
+namespace esphome {
+namespace neewerlight_pool {
+
+void NeewerConnectionPool::add_light(NeewerRGBCTLightOutput *output) {
+  output->set_pooled(true);
+  Member member;
+  member.output = output;
+  this->members_.push_back(member);
+}
+
+void NeewerConnectionPool::dump_config() {
+  ESP_LOGCONFIG(TAG, "Neewer connection pool:");
+  ESP_LOGCONFIG(TAG, "  Max connections    : %u", this->max_connections_);
+  ESP_LOGCONFIG(TAG, "  Connect timeout    : %ums", this->connect_timeout_ms_);
+  for (const auto &member : this->members_) {
+    ESP_LOGCONFIG(TAG, "  Light %u            : %s", member.output->get_light_id(),
+                  member.output->parent()->address_str());
+  }
+}
+
+void NeewerConnectionPool::loop() {
+  const uint32_t now = millis();
+  if (!this->started_) {
+    // Runs after every ble_client's setup(), which enables its client.
+    for (auto &member : this->members_)
+      member.output->parent()->set_enabled(false);
+    this->started_ = true;
+  }
+
+  for (auto &member : this->members_)
+    this->update_member_(member, now);
+  this->grant_slots_(now);
+
+  if (this->stats_interval_ms_ != 0 && now - this->last_stats_ms_ >= this->stats_interval_ms_) {
+    this->last_stats_ms_ = now;
+    this->log_stats_();
+  }
+}
+
+void NeewerConnectionPool::update_member_(Member &member, uint32_t now) {
+  auto *output = member.output;
+  if (member.releasing && !output->is_connected())
+    member.releasing = false;
+
+  if (!member.enabled) {
+    if (!member.waiting && output->link_wanted()) {
+      member.waiting = true;
+      member.demand_ms = now;
+      member.queued_ms = now;
+    }
+    return;
+  }
+
+  if (member.waiting) {
+    if (output->is_link_ready()) {
+      member.waiting = false;
+      member.last_used_ms = now;
+      const uint32_t delay = now - member.demand_ms;
+      member.delay_last_ms = delay;
+      member.delay_avg_ms = member.delay_avg_ms == 0 ? delay : (member.delay_avg_ms * 7 + delay) / 8;
+      member.delay_max_ms = std::max(member.delay_max_ms, delay);
+      ESP_LOGD(TAG, "Light %u connected %ums after it was needed (%ums waiting for a slot)",
+               output->get_light_id(), delay, member.enabled_ms - member.demand_ms);
+    } else if (now - member.enabled_ms >= this->connect_timeout_ms_) {
+      // Out of range or switched off; let the others have the slot and retry later.
+      ESP_LOGW(TAG, "Light %u did not connect within %ums, requeued", output->get_light_id(),
+               this->connect_timeout_ms_);
+      member.connect_timeouts++;
+      this->release_(member);
+      member.waiting = true;
+      member.queued_ms = now;
+    }
+    return;
+  }
+
+  if (!output->is_link_ready()) {
+    // The link dropped on its own. Keep the slot only if the light still has
+    // something to send, and give up on it after connect_timeout as above.
+    if (output->link_wanted()) {
+      member.waiting = true;
+      member.demand_ms = now;
+      member.enabled_ms = now;
+    } else {
+      this->release_(member);
+    }
+    return;
+  }
+  if (output->holds_link())
+    member.last_used_ms = now;
+}
+
+// Waiting lights are served in the order they asked. A full pool makes room by
+// disconnecting its least recently used light that holds nothing.
+void NeewerConnectionPool::grant_slots_(uint32_t now) {
+  Member *next;
+  while ((next = this->next_waiting_()) != nullptr) {
+    if (this->slots_in_use_() >= this->max_connections_) {
+      Member *victim = this->least_recently_used_();
+      if (victim == nullptr)
+        return;
+      ESP_LOGD(TAG, "Disconnecting light %u (idle %ums) for light %u", victim->output->get_light_id(),
+               now - victim->last_used_ms, next->output->get_light_id());
+      victim->evictions++;
+      this->release_(*victim);
+      // The slot frees up once the disconnect has gone through.
+      return;
+    }
+    this->connect_(*next, now);
+  }
+}
+
+NeewerConnectionPool::Member *NeewerConnectionPool::next_waiting_() {
+  Member *next = nullptr;
+  for (auto &member : this->members_) {
+    if (member.waiting && !member.enabled &&
+        (next == nullptr || static_cast<int32_t>(member.queued_ms - next->queued_ms) < 0))
+      next = &member;
+  }
+  return next;
+}
+
+NeewerConnectionPool::Member *NeewerConnectionPool::least_recently_used_() {
+  const uint32_t now = millis();
+  Member *victim = nullptr;
+  for (auto &member : this->members_) {
+    if (!member.enabled || member.waiting || member.output->holds_link())
+      continue;
+    if (victim == nullptr || now - member.last_used_ms > now - victim->last_used_ms)
+      victim = &member;
+  }
+  return victim;
+}
+
+uint8_t NeewerConnectionPool::slots_in_use_() const {
+  uint8_t used = 0;
+  for (const auto &member : this->members_) {
+    if (member.enabled || member.releasing)
+      used++;
+  }
+  return used;
+}
+
+void NeewerConnectionPool::connect_(Member &member, uint32_t now) {
+  member.enabled = true;
+  member.enabled_ms = now;
+  member.connects++;
+  member.slot_wait_max_ms = std::max(member.slot_wait_max_ms, now - member.demand_ms);
+  member.output->parent()->set_enabled(true);
+}
+
+void NeewerConnectionPool::release_(Member &member) {
+  member.enabled = false;
+  member.releasing = member.output->is_connected();
+  member.output->parent()->set_enabled(false);
+}
+
+// One line per light: a pool is meant for more lights than one log line holds.
+void NeewerConnectionPool::log_stats_() {
+  uint8_t waiting = 0;
+  for (const auto &member : this->members_) {
+    if (member.waiting && !member.enabled)
+      waiting++;
+  }
+  const uint8_t slots_used = this->slots_in_use_();
+  for (auto &member : this->members_) {
+    ESP_LOGI(TAG,
+             "[nwpool] {\"slots\":%u,\"slots_used\":%u,\"waiting\":%u,\"light\":%u,\"connected\":%s,"
+             "\"connects\":%u,\"evictions\":%u,\"timeouts\":%u,\"delay_ms_last\":%u,\"delay_ms_avg\":%u,"
+             "\"delay_ms_max\":%u,\"slot_wait_ms_max\":%u}",
+             this->max_connections_, slots_used, waiting, member.output->get_light_id(),
+             member.output->is_connected() ? "true" : "false", member.connects, member.evictions,
+             member.connect_timeouts, member.delay_last_ms, member.delay_avg_ms, member.delay_max_ms,
+             member.slot_wait_max_ms);
+    member.delay_max_ms = 0;
+    member.slot_wait_max_ms = 0;
+  }
+}
+
+}  // namespace neewerlight_pool
+}  // namespace esphome
+
+#endif  // USE_ESP32
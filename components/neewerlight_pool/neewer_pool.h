@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include "../../core/component.h"
+#include "../../core/log.h"
+#include "../neewerlight/neewer_light_output.h"
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight_pool {
+
+using neewerlight::NeewerRGBCTLightOutput;
+
+// Shares a few BLE connections between more lights than the controller can hold
+// open. Every pooled light starts disconnected. A light that is sent a command
+// while disconnected waits for a slot; once it is connected, the reconnect resync
+// sends its desired state. When all slots are taken, the connected light that
+// was used least recently is disconnected, but only if nothing is queued, in
+// flight or being verified on it and no effect is running.
+class NeewerConnectionPool : public Component {
+ public:
+    void add_light(NeewerRGBCTLightOutput *output);
+    void set_max_connections(uint8_t max_connections) { this->max_connections_ = max_connections; }
+    void set_connect_timeout(uint32_t timeout_ms) { this->connect_timeout_ms_ = timeout_ms; }
+    void set_stats_interval(uint32_t interval_ms) { this->stats_interval_ms_ = interval_ms; }
+
+    void loop() override;
+    void dump_config() override;
+
+ protected:
+    struct Member {
+      NeewerRGBCTLightOutput *output;
+      bool enabled = false;     // holds a slot (connecting or connected)
+      bool releasing = false;   // disabled, slot free once the link is down
+      bool waiting = false;     // wants a slot
+      uint32_t demand_ms = 0;   // first command while disconnected
+      uint32_t queued_ms = 0;   // position in the wait queue
+      uint32_t enabled_ms = 0;
+      uint32_t last_used_ms = 0;
+      uint32_t connects = 0;
+      uint32_t evictions = 0;
+      uint32_t connect_timeouts = 0;
+      // Queueing delay: command while disconnected to light controllable.
+      uint32_t delay_last_ms = 0;
+      uint32_t delay_avg_ms = 0;
+      uint32_t delay_max_ms = 0;
+      // Part of it spent waiting for a free slot.
+      uint32_t slot_wait_max_ms = 0;
+    };
+
+    void update_member_(Member &member, uint32_t now);
+    void grant_slots_(uint32_t now);
+    Member *next_waiting_();
+    Member *least_recently_used_();
+    uint8_t slots_in_use_() const;
+    void connect_(Member &member, uint32_t now);
+    void release_(Member &member);
+    void log_stats_();
+
+    std::vector<Member> members_;
+    uint8_t max_connections_ = 3;
+    uint32_t connect_timeout_ms_ = 20000;
+    bool started_ = false;
+
+    uint32_t stats_interval_ms_ = 0;
+    uint32_t last_stats_ms_ = 0;
+
+    const char* const TAG = "neewer_pool";
+};
+
+}  // namespace neewerlight_pool
+}  // namespace esphome
+
+#endif  // USE_ESP32
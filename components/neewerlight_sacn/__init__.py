@@ -0,0 +1,71 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components.neewerlight import light as nw_light
+from esphome.const import CONF_ID, CONF_OUTPUT_ID, CONF_PORT
+
+CODEOWNERS = ["@litui"]
+DEPENDENCIES = ["network", "neewerlight"]
+AUTO_LOAD = ["socket"]
+
+CONF_LIGHTS = "lights"
+CONF_UNIVERSE = "universe"
+CONF_START_ADDRESS = "start_address"
+CONF_MULTICAST = "multicast"
+CONF_STATS_INTERVAL = "stats_interval"
+
+# Slots per light: intensity, CCT, hue, saturation, FX (see neewer_sacn.h).
+FOOTPRINT_SIZE = 5
+
+neewerlight_sacn_ns = cg.esphome_ns.namespace("neewerlight_sacn")
+NeewerSACNComponent = neewerlight_sacn_ns.class_("NeewerSACNComponent", cg.Component)
+
+
+def _validate_footprints(config):
+    taken = {}
+    for entry in config[CONF_LIGHTS]:
+        universe = entry[CONF_UNIVERSE]
+        start = entry[CONF_START_ADDRESS]
+        for slot in range(start, start + FOOTPRINT_SIZE):
+            if (universe, slot) in taken:
+                raise cv.Invalid(
+                    f"Universe {universe} slot {slot} is used by both {taken[(universe, slot)]} "
+                    f"and {entry[CONF_OUTPUT_ID]}"
+                )
+            taken[(universe, slot)] = entry[CONF_OUTPUT_ID]
+    return config
+
+
+LIGHT_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_OUTPUT_ID): cv.use_id(nw_light.NeewerRGBCTLightOutput),
+        cv.Required(CONF_UNIVERSE): cv.int_range(min=1, max=63999),
+        cv.Optional(CONF_START_ADDRESS, default=1): cv.int_range(
+            min=1, max=512 - FOOTPRINT_SIZE + 1
+        ),
+    }
+)
+
+CONFIG_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(NeewerSACNComponent),
+            cv.Optional(CONF_PORT, default=5568): cv.port,
+            cv.Optional(CONF_MULTICAST, default=True): cv.boolean,
+            cv.Optional(CONF_STATS_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Required(CONF_LIGHTS): cv.All(cv.ensure_list(LIGHT_SCHEMA), cv.Length(min=1)),
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    _validate_footprints,
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    cg.add(var.set_port(config[CONF_PORT]))
+    cg.add(var.set_multicast(config[CONF_MULTICAST]))
+    if CONF_STATS_INTERVAL in config:
+        cg.add(var.set_stats_interval(config[CONF_STATS_INTERVAL]))
+    for entry in config[CONF_LIGHTS]:
+        output = await cg.get_variable(entry[CONF_OUTPUT_ID])
+        cg.add(var.add_light(output, entry[CONF_UNIVERSE], entry[CONF_START_ADDRESS]))
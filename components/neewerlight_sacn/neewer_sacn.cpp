@@ -0,0 +1,249 @@
+#include "neewer_sacn.h"
+
+#ifdef USE_ESP32
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "../../core/hal.h"
+#include "../../core/helpers.h"
+
+namespace esphome {
+namespace neewerlight_sacn {
+
+// E1.31-2016 data packet layout (ANSI E1.31, section 4).
+static const uint8_t ACN_PACKET_IDENTIFIER[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+static const uint16_t ACN_PACKET_IDENTIFIER_OFFSET = 4;
+static const uint16_t ROOT_VECTOR_OFFSET = 18;
+static const uint16_t FRAMING_VECTOR_OFFSET = 40;
+static const uint16_t SEQUENCE_OFFSET = 111;
+static const uint16_t OPTIONS_OFFSET = 112;
+static const uint16_t UNIVERSE_OFFSET = 113;
+static const uint16_t DMP_VECTOR_OFFSET = 117;
+static const uint16_t PROPERTY_COUNT_OFFSET = 123;
+static const uint16_t START_CODE_OFFSET = 125;
+static const uint32_t VECTOR_ROOT_E131_DATA = 0x00000004;
+static const uint32_t VECTOR_E131_DATA_PACKET = 0x00000002;
+static const uint8_t VECTOR_DMP_SET_PROPERTY = 0x02;
+static const uint8_t OPTION_PREVIEW_DATA = 0x80;
+static const uint8_t DMX_START_CODE = 0x00;
+// Packets per loop() pass; anything left is read on the next pass.
+static const uint8_t MAX_PACKETS_PER_LOOP = 16;
+
+static uint16_t read_u16_be(const uint8_t *data) { return (data[0] << 8) | data[1]; }
+static uint32_t read_u32_be(const uint8_t *data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+void NeewerSACNComponent::add_light(NeewerRGBCTLightOutput *output, uint16_t universe, uint16_t start_address) {
+  Light light{};
+  light.output = output;
+  light.universe = universe;
+  light.start_address = start_address;
+  this->lights_.push_back(light);
+  for (const auto &entry : this->universes_) {
+    if (entry.number == universe)
+      return;
+  }
+  this->universes_.push_back(Universe{universe, 0, false});
+}
+
+void NeewerSACNComponent::setup() {
+  this->socket_ = socket::socket_ip(SOCK_DGRAM, IPPROTO_IP);
+  if (this->socket_ == nullptr) {
+    ESP_LOGE(TAG, "Could not create socket");
+    this->mark_failed();
+    return;
+  }
+  int enable = 1;
+  this->socket_->setsockopt(SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  this->socket_->setblocking(false);
+
+  struct sockaddr_storage server;
+  const socklen_t server_len =
+      socket::set_sockaddr_any(reinterpret_cast<struct sockaddr *>(&server), sizeof(server), this->port_);
+  if (server_len == 0 || this->socket_->bind(reinterpret_cast<struct sockaddr *>(&server), server_len) != 0) {
+    ESP_LOGE(TAG, "Could not bind UDP port %u: errno %d", this->port_, errno);
+    this->mark_failed();
+    return;
+  }
+  if (this->multicast_) {
+    for (const auto &entry : this->universes_)
+      this->join_universe_(entry.number);
+  }
+}
+
+// Each universe has its own multicast group, 239.255.<universe high>.<universe low>.
+void NeewerSACNComponent::join_universe_(uint16_t universe) {
+  struct ip_mreq request {};
+  request.imr_multiaddr.s_addr = htonl((239u << 24) | (255u << 16) | universe);
+  request.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (this->socket_->setsockopt(IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0)
+    ESP_LOGW(TAG, "Could not join the multicast group of universe %u: errno %d", universe, errno);
+}
+
+void NeewerSACNComponent::dump_config() {
+  ESP_LOGCONFIG(TAG, "Neewer sACN:");
+  ESP_LOGCONFIG(TAG, "  UDP port           : %u", this->port_);
+  ESP_LOGCONFIG(TAG, "  Multicast          : %s", this->multicast_ ? "yes" : "no (unicast only)");
+  for (const auto &light : this->lights_) {
+    ESP_LOGCONFIG(TAG, "  Light %u            : universe %u, slots %u-%u", light.output->get_light_id(),
+                  light.universe, light.start_address, light.start_address + SACN_FOOTPRINT_SIZE - 1);
+  }
+}
+
+void NeewerSACNComponent::loop() {
+  if (this->socket_ == nullptr)
+    return;
+  for (uint8_t i = 0; i < MAX_PACKETS_PER_LOOP; i++) {
+    const ssize_t length = this->socket_->read(this->buffer_, sizeof(this->buffer_));
+    if (length <= 0)
+      break;
+    this->packets_++;
+    if (!this->handle_packet_(this->buffer_, static_cast<uint16_t>(length), micros()))
+      this->packets_ignored_++;
+  }
+
+  const uint32_t now = millis();
+  for (auto &light : this->lights_) {
+    this->check_latency_(light);
+    if (light.has_pending && light.output->link_idle() &&
+        now - light.last_send_ms >= light.output->get_min_frame_interval())
+      this->send_light_(light);
+  }
+
+  if (this->stats_interval_ms_ != 0 && now - this->last_stats_ms_ >= this->stats_interval_ms_) {
+    this->last_stats_ms_ = now;
+    this->log_stats_();
+  }
+}
+
+// Returns false for anything that isn't DMX data for one of our universes.
+bool NeewerSACNComponent::handle_packet_(const uint8_t *data, uint16_t length, uint32_t rx_us) {
+  if (length <= SACN_DMX_DATA_OFFSET ||
+      memcmp(data + ACN_PACKET_IDENTIFIER_OFFSET, ACN_PACKET_IDENTIFIER, sizeof(ACN_PACKET_IDENTIFIER)) != 0 ||
+      read_u32_be(data + ROOT_VECTOR_OFFSET) != VECTOR_ROOT_E131_DATA ||
+      read_u32_be(data + FRAMING_VECTOR_OFFSET) != VECTOR_E131_DATA_PACKET ||
+      data[DMP_VECTOR_OFFSET] != VECTOR_DMP_SET_PROPERTY || data[START_CODE_OFFSET] != DMX_START_CODE ||
+      (data[OPTIONS_OFFSET] & OPTION_PREVIEW_DATA) != 0)
+    return false;
+
+  const uint16_t number = read_u16_be(data + UNIVERSE_OFFSET);
+  Universe *universe = nullptr;
+  for (auto &entry : this->universes_) {
+    if (entry.number == number)
+      universe = &entry;
+  }
+  if (universe == nullptr)
+    return false;
+
+  // E1.31 6.7.2: a packet up to 20 sequence numbers behind the last one is stale.
+  const int8_t step = static_cast<int8_t>(data[SEQUENCE_OFFSET] - universe->sequence);
+  if (universe->seen && step <= 0 && step > -20) {
+    this->packets_out_of_order_++;
+    return true;
+  }
+  universe->sequence = data[SEQUENCE_OFFSET];
+  universe->seen = true;
+
+  // The property count includes the start code.
+  uint16_t slots = read_u16_be(data + PROPERTY_COUNT_OFFSET);
+  slots = slots > 0 ? slots - 1 : 0;
+  slots = std::min<uint16_t>(slots, length - SACN_DMX_DATA_OFFSET);
+  for (auto &light : this->lights_) {
+    if (light.universe != number || light.start_address - 1 + SACN_FOOTPRINT_SIZE > slots)
+      continue;
+    const uint8_t *footprint = data + SACN_DMX_DATA_OFFSET + light.start_address - 1;
+    if (light.has_pending) {
+      if (memcmp(light.pending, footprint, SACN_FOOTPRINT_SIZE) == 0)
+        continue;  // a refresh of the frame already waiting keeps its arrival time
+      light.superseded++;
+    } else if (light.has_applied && memcmp(light.applied, footprint, SACN_FOOTPRINT_SIZE) == 0) {
+      continue;  // a refresh of what the light already shows
+    }
+    memcpy(light.pending, footprint, SACN_FOOTPRINT_SIZE);
+    light.has_pending = true;
+    light.pending_rx_us = rx_us;
+  }
+  return true;
+}
+
+void NeewerSACNComponent::send_light_(Light &light) {
+  const uint8_t *slots = light.pending;
+  const uint8_t scene_id = slots[SLOT_FX] / 10;
+  const bool scene_update = !light.has_applied || scene_id != light.applied[SLOT_FX] / 10 ||
+                            slots[SLOT_INTENSITY] != light.applied[SLOT_INTENSITY];
+  memcpy(light.applied, slots, SACN_FOOTPRINT_SIZE);
+  light.has_applied = true;
+  light.has_pending = false;
+  light.last_send_ms = millis();
+  light.frames++;
+
+  auto *output = light.output;
+  NeewerLightTarget target;
+  const float intensity = slots[SLOT_INTENSITY] / 255.0f;
+  target.on = slots[SLOT_INTENSITY] > 0;
+  if (scene_id != 0 && target.on) {
+    // The light runs the scene itself at the intensity slot's brightness; it only
+    // restarts when the FX or intensity slot changes. Scene frames are not part of
+    // the latency figures.
+    if (scene_update)
+      output->activate_scene(scene_id, intensity);
+    light.sequence = 0;
+    return;
+  }
+
+  target.color_temperature = 1.0f - slots[SLOT_CCT] / 255.0f;  // 0 is the cold end
+  if (slots[SLOT_SATURATION] == 0) {
+    target.white_brightness = intensity;
+  } else {
+    hsv_to_rgb(slots[SLOT_HUE] * 360 / 256, slots[SLOT_SATURATION] / 255.0f, intensity, target.red, target.green,
+               target.blue);
+  }
+  const auto frame_class = output->encode_target(&target);
+  const uint32_t sequence = output->apply_target(target, output->get_encoded_frame(), frame_class);
+  if (sequence != 0) {
+    light.sequence = sequence;
+    light.sequence_rx_us = light.pending_rx_us;
+  }
+}
+
+// Input-to-wire latency: from reading the packet to the light acknowledging the
+// frame it produced.
+void NeewerSACNComponent::check_latency_(Light &light) {
+  if (light.sequence == 0 || !light.output->is_acknowledged(light.sequence))
+    return;
+  light.sequence = 0;
+  const uint32_t latency_us = light.output->get_acked_us() - light.sequence_rx_us;
+  light.latency_last_us = latency_us;
+  light.latency_avg_us = light.latency_avg_us == 0 ? latency_us : (light.latency_avg_us * 7 + latency_us) / 8;
+  light.latency_max_us = std::max(light.latency_max_us, latency_us);
+  ESP_LOGV(TAG, "Light %u: input to wire %.1fms", light.output->get_light_id(), latency_us / 1000.0f);
+}
+
+void NeewerSACNComponent::log_stats_() {
+  char lights[384];
+  size_t used = 0;
+  for (auto &light : this->lights_) {
+    const int written = snprintf(lights + used, sizeof(lights) - used,
+                                 "%s{\"light\":%u,\"frames\":%u,\"superseded\":%u,\"latency_ms_last\":%.1f,"
+                                 "\"latency_ms_avg\":%.1f,\"latency_ms_max\":%.1f}",
+                                 used == 0 ? "" : ",", light.output->get_light_id(), light.frames, light.superseded,
+                                 light.latency_last_us / 1000.0f, light.latency_avg_us / 1000.0f,
+                                 light.latency_max_us / 1000.0f);
+    if (written < 0 || static_cast<size_t>(written) >= sizeof(lights) - used)
+      break;
+    used += written;
+    light.latency_max_us = 0;
+  }
+  lights[used] = '\0';
+  ESP_LOGI(TAG, "[nwsacn] {\"packets\":%u,\"ignored\":%u,\"out_of_order\":%u,\"lights\":[%s]}", this->packets_,
+           this->packets_ignored_, this->packets_out_of_order_, lights);
+}
+
+}  // namespace neewerlight_sacn
+}  // namespace esphome
+
+#endif  // USE_ESP32
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../socket/socket.h"
+#include "../../core/component.h"
+#include "../../core/log.h"
+#include "../neewerlight/neewer_light_output.h"
+
+#ifdef USE_ESP32
+
+namespace esphome {
+namespace neewerlight_sacn {
+
+using neewerlight::NeewerLightTarget;
+using neewerlight::NeewerRGBCTLightOutput;
+
+static const uint16_t SACN_DEFAULT_PORT = 5568;
+static const uint16_t SACN_MAX_PACKET_SIZE = 638;  // full universe: 126-byte header, start code, 512 slots
+static const uint16_t SACN_DMX_DATA_OFFSET = 126;  // first slot after the start code
+
+// DMX footprint of one light, in slot order from its start address.
+enum SACNFootprintSlot : uint8_t {
+    SLOT_INTENSITY = 0,   // 0 = off
+    SLOT_CCT = 1,         // 0 = warmest, 255 = coldest the model supports
+    SLOT_HUE = 2,         // 0-255 over 0-360 degrees
+    SLOT_SATURATION = 3,  // 0 = white mode (intensity + CCT), else colour mode
+    SLOT_FX = 4,          // 0-9 none, then 10 values per scene id: 10-19 = scene 1, ...
+    SACN_FOOTPRINT_SIZE = 5,
+};
+
+// Receives E1.31 (sACN) universes over UDP and drives neewerlight outputs from
+// their DMX footprints. A console repeats every universe at up to 44 Hz, far
+// more than a BLE light takes, so each light only keeps the newest footprint it
+// was sent. A footprint is encoded and handed to the light once its link is
+// idle and its max_frame_rate allows, and one that didn't change since the last
+// send is dropped.
+class NeewerSACNComponent : public Component {
+ public:
+    void set_port(uint16_t port) { this->port_ = port; }
+    void set_multicast(bool multicast) { this->multicast_ = multicast; }
+    void set_stats_interval(uint32_t interval_ms) { this->stats_interval_ms_ = interval_ms; }
+    void add_light(NeewerRGBCTLightOutput *output, uint16_t universe, uint16_t start_address);
+
+    void setup() override;
+    void loop() override;
+    void dump_config() override;
+    float get_setup_priority() const override { return setup_priority::AFTER_WIFI; }
+
+ protected:
+    struct Light {
+      NeewerRGBCTLightOutput *output;
+      uint16_t universe;
+      uint16_t start_address;  // 1-based DMX address of SLOT_INTENSITY
+      uint8_t pending[SACN_FOOTPRINT_SIZE];
+      uint8_t applied[SACN_FOOTPRINT_SIZE];
+      bool has_pending = false;
+      bool has_applied = false;
+      uint32_t pending_rx_us = 0;  // arrival of the packet that carried `pending`
+      uint32_t last_send_ms = 0;
+      // Frame waiting for its ack, and when the packet behind it arrived.
+      uint32_t sequence = 0;
+      uint32_t sequence_rx_us = 0;
+      uint32_t frames = 0;
+      uint32_t superseded = 0;
+      uint32_t latency_last_us = 0;
+      uint32_t latency_avg_us = 0;
+      uint32_t latency_max_us = 0;
+    };
+    struct Universe {
+      uint16_t number;
+      uint8_t sequence;
+      bool seen;
+    };
+
+    void join_universe_(uint16_t universe);
+    bool handle_packet_(const uint8_t *data, uint16_t length, uint32_t rx_us);
+    void send_light_(Light &light);
+    void check_latency_(Light &light);
+    void log_stats_();
+
+    std::unique_ptr<socket::Socket> socket_;
+    uint8_t buffer_[SACN_MAX_PACKET_SIZE];
+    std::vector<Light> lights_;
+    std::vector<Universe> universes_;
+    uint16_t port_ = SACN_DEFAULT_PORT;
+    bool multicast_ = true;
+
+    uint32_t packets_ = 0;
+    uint32_t packets_ignored_ = 0;
+    uint32_t packets_out_of_order_ = 0;
+    uint32_t stats_interval_ms_ = 0;
+    uint32_t last_stats_ms_ = 0;
+
+    const char* const TAG = "neewer_sacn";
+};
+
+}  // namespace neewerlight_sacn
+}  // namespace esphome
+
+#endif  // USE_ESP32
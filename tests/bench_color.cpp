@@ -0,0 +1,53 @@
+// Time per conversion of neewer_rgb_to_hsi and the float conversion it
+// replaced, over the whole 8-bit RGB cube. Prints one JSON line. On the host
+// FPU the gap is far smaller than on an FPU-less ESP32-C3; compare runs of the
+// same binary on the same machine.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../components/neewerlight/neewer_color.h"
+#include "reference_rgb_to_hsb.h"
+
+using esphome::neewerlight::neewer_rgb_to_hsi;
+
+template<typename Convert> static double ns_per_call(int rounds, uint32_t *sink, Convert convert) {
+  float levels[256];
+  for (int i = 0; i < 256; i++)
+    levels[i] = i / 255.0f;
+  const auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (int r = 0; r < 256; r++) {
+      for (int g = 0; g < 256; g++) {
+        for (int b = 0; b < 256; b++)
+          *sink += convert(levels[r], levels[g], levels[b]);
+      }
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / (double(rounds) * 256 * 256 * 256);
+}
+
+int main(int argc, char **argv) {
+  const int rounds = argc > 1 ? atoi(argv[1]) : 1;
+  uint32_t sink = 0;
+  const double fixed_ns = ns_per_call(rounds, &sink, [](float red, float green, float blue) {
+    uint16_t hue;
+    uint8_t saturation;
+    uint8_t brightness;
+    neewer_rgb_to_hsi(red, green, blue, &hue, &saturation, &brightness);
+    return uint32_t(hue) + saturation + brightness;
+  });
+  const double float_ns = ns_per_call(rounds, &sink, [](float red, float green, float blue) {
+    int hue;
+    uint8_t saturation;
+    uint8_t brightness;
+    reference_rgb_to_hsb(red, green, blue, &hue, &saturation, &brightness);
+    return uint32_t(hue) + saturation + brightness;
+  });
+  printf("{\"bench\":\"rgb_to_hsi\",\"colours\":%d,\"rounds\":%d,\"fixed_ns_per_call\":%.2f,"
+         "\"float_ns_per_call\":%.2f,\"speedup\":%.2f,\"sink\":%u}\n",
+         256 * 256 * 256, rounds, fixed_ns, float_ns, float_ns / fixed_ns, sink);
+  return 0;
+}
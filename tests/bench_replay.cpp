@@ -0,0 +1,209 @@
+// Replays typical Home Assistant workloads through NeewerRGBCTLightOutput::write_state
+// against simulated lights and prints one JSON line per workload: light calls,
+// frames and bytes on the wire (per command class), and CPU time per call. The
+// traffic figures are deterministic, so two runs diff cleanly in review; the
+// *_ns figures are host CPU time and only compare on the same machine.
+//
+//   bench_replay > before.json ... bench_replay > after.json && diff before.json after.json
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sim/neewer_sim.h"
+#include "sim/neewer_sim_models.h"
+
+using namespace esphome;
+using namespace esphome::neewerlight;
+using namespace esphome::neewer_sim;
+
+static double now_ns() {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template<typename Model> class Rig {
+ public:
+  using Output = NeewerModelLightOutput<Model>;
+
+  explicit Rig(int lights) {
+    for (int i = 0; i < lights; i++) {
+      this->outputs_.emplace_back(new Output());
+      this->states_.emplace_back(new light::LightState(this->outputs_.back().get()));
+      this->links_.push_back(&this->world_.add_light(this->outputs_.back().get(), 0xF80C31D67400ULL + i));
+    }
+    for (auto *link : this->links_)
+      link->connect();
+    // Connect, read the initial status, and start counting from there.
+    this->world_.run_for(2000);
+    for (auto &output : this->outputs_)
+      this->baseline_.push_back(output->get_stats());
+    for (auto *link : this->links_)
+      this->sim_baseline_.push_back(link->light().counters());
+  }
+
+  void set(int light, bool on, float red, float green, float blue, float color_temperature, float white_brightness,
+           bool transition = false) {
+    auto &state = *this->states_[light];
+    state.set_rgbct(on, red, green, blue, color_temperature, white_brightness);
+    state.set_transformer_active(transition);
+    NeewerLightTarget target;
+    target.on = on;
+    target.red = red;
+    target.green = green;
+    target.blue = blue;
+    target.color_temperature = color_temperature;
+    target.white_brightness = white_brightness;
+    this->targets_.push_back(target);
+
+    auto &output = static_cast<light::LightOutput &>(*this->outputs_[light]);
+    const double start = now_ns();
+    output.write_state(&state);
+    this->write_state_ns_ += now_ns() - start;
+  }
+
+  void scene(int light, NeewerSceneLightEffect *effect) {
+    auto &state = *this->states_[light];
+    const double start = now_ns();
+    state.start_effect(effect);
+    static_cast<light::LightOutput &>(*this->outputs_[light]).write_state(&state);
+    this->write_state_ns_ += now_ns() - start;
+  }
+
+  void run_for(uint32_t ms) { this->world_.run_for(ms); }
+
+  void report(const char *workload) {
+    NeewerLinkStats total;
+    uint32_t suppressed = 0;
+    for (size_t i = 0; i < this->outputs_.size(); i++) {
+      const auto &stats = this->outputs_[i]->get_stats();
+      const auto &before = this->baseline_[i];
+      total.light_calls += stats.light_calls - before.light_calls;
+      total.frames_sent += stats.frames_sent - before.frames_sent;
+      total.bytes_sent += stats.bytes_sent - before.bytes_sent;
+      for (uint8_t c = 0; c < COMMAND_CLASS_COUNT; c++)
+        total.frames_by_class[c] += stats.frames_by_class[c] - before.frames_by_class[c];
+      total.user_frames += stats.user_frames - before.user_frames;
+      total.user_latency_us_total += stats.user_latency_us_total - before.user_latency_us_total;
+      total.write_failures += stats.write_failures - before.write_failures;
+      suppressed += this->outputs_[i]->get_suppressed_writes();
+    }
+    uint32_t received = 0;
+    for (size_t i = 0; i < this->links_.size(); i++) {
+      const auto &counters = this->links_[i]->light().counters();
+      received += (counters.writes - counters.lost - counters.ignored) - (this->sim_baseline_[i].writes);
+    }
+    const uint32_t calls = total.light_calls;
+    printf("{\"workload\":\"%s\",\"lights\":%u,\"calls\":%u,\"frames\":%u,\"frames_per_call\":%.3f,\"bytes\":%u,"
+           "\"power\":%u,\"hsi\":%u,\"cct\":%u,\"fx\":%u,\"power_status\":%u,\"channel_status\":%u,"
+           "\"suppressed\":%u,\"received\":%u,\"write_failures\":%u,\"user_latency_ms_avg\":%.1f,"
+           "\"write_state_ns\":%.0f,\"encode_ns\":%.0f}\n",
+           workload, static_cast<unsigned>(this->outputs_.size()), calls, total.frames_sent,
+           calls == 0 ? 0.0 : double(total.frames_sent) / calls, total.bytes_sent,
+           total.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::POWER)],
+           total.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::HSI)],
+           total.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::CCT)],
+           total.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::FX)],
+           total.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::POWER_STATUS)],
+           total.frames_by_class[static_cast<uint8_t>(NeewerCommandClass::CHANNEL_STATUS)], suppressed, received,
+           total.write_failures,
+           total.user_frames == 0 ? 0.0 : double(total.user_latency_us_total) / total.user_frames / 1000.0,
+           calls == 0 ? 0.0 : this->write_state_ns_ / calls, this->encode_ns_per_call_());
+  }
+
+ protected:
+  // The prepare_* / rgb_to_hsi cost alone: the workload's targets encoded again
+  // on a light that isn't connected, repeated to get above timer resolution.
+  double encode_ns_per_call_() {
+    if (this->targets_.empty())
+      return 0.0;
+    Output output;
+    const size_t repeats = 200000 / this->targets_.size() + 1;
+    const double start = now_ns();
+    for (size_t r = 0; r < repeats; r++) {
+      for (const auto &original : this->targets_) {
+        NeewerLightTarget target = original;
+        output.encode_target(&target);
+      }
+    }
+    return (now_ns() - start) / (repeats * this->targets_.size());
+  }
+
+  SimWorld world_;
+  std::vector<std::unique_ptr<Output>> outputs_;
+  std::vector<std::unique_ptr<light::LightState>> states_;
+  std::vector<SimLink *> links_;
+  std::vector<NeewerLinkStats> baseline_;
+  std::vector<SimCounters> sim_baseline_;
+  std::vector<NeewerLightTarget> targets_;
+  double write_state_ns_ = 0.0;
+};
+
+// Dragging a brightness slider: a white light gets a new level every 50 ms for
+// 2 s, without a transition.
+static void slider_drag() {
+  Rig<NeewerRgb660Model> rig(1);
+  rig.set(0, true, 0.0f, 0.0f, 0.0f, 0.4f, 1.0f);
+  rig.run_for(1500);
+  for (int i = 0; i < 40; i++) {
+    rig.set(0, true, 0.0f, 0.0f, 0.0f, 0.4f, 1.0f - i * 0.02f);
+    rig.run_for(50);
+  }
+  rig.run_for(3000);
+  rig.report("slider_drag");
+}
+
+// A 2 s colour transition, written on every main loop pass (16 ms) the way
+// LightState drives a transformer.
+static void transition_2s() {
+  Rig<NeewerRgb660Model> rig(1);
+  rig.set(0, true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  rig.run_for(1500);
+  const int steps = 2000 / 16;
+  for (int i = 1; i <= steps; i++) {
+    const float progress = float(i) / steps;
+    rig.set(0, true, 1.0f - progress, 0.0f, progress, 0.0f, 0.0f, i < steps);
+    rig.run_for(16);
+  }
+  rig.run_for(3000);
+  rig.report("transition_2s");
+}
+
+// An automation switching ten lights on and off together, five times.
+static void ten_light_toggle() {
+  Rig<NeewerRgb660Model> rig(10);
+  for (int round = 0; round < 5; round++) {
+    for (int light = 0; light < 10; light++)
+      rig.set(light, true, 0.0f, 0.0f, 0.0f, 0.5f, 0.8f);
+    rig.run_for(3000);
+    for (int light = 0; light < 10; light++)
+      rig.set(light, false, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f);
+    rig.run_for(3000);
+  }
+  rig.report("ten_light_toggle");
+}
+
+// Stepping through the FX scenes of an RGB62, then back to plain white.
+static void scene_switch() {
+  Rig<NeewerRgb62Model> rig(1);
+  rig.set(0, true, 0.0f, 0.0f, 0.0f, 0.5f, 0.7f);
+  rig.run_for(1500);
+  std::vector<std::unique_ptr<NeewerSceneLightEffect>> effects;
+  for (uint8_t id = 1; id <= NeewerRgb62Model::SCENE_COUNT; id++) {
+    effects.emplace_back(new NeewerSceneLightEffect(NeewerRgb62Model::SCENES[id - 1].name, id));
+    rig.scene(0, effects.back().get());
+    rig.run_for(2000);
+  }
+  rig.set(0, true, 0.0f, 0.0f, 0.0f, 0.5f, 0.7f);
+  rig.run_for(3000);
+  rig.report("scene_switch");
+}
+
+int main() {
+  slider_drag();
+  transition_2s();
+  ten_light_toggle();
+  scene_switch();
+  return 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../esp32_ble_tracker/esp32_ble_tracker.h"
+
+namespace esphome {
+namespace ble_client {
+
+namespace espbt = esp32_ble_tracker;
+
+class BLEDescriptor {
+ public:
+  espbt::ESPBTUUID uuid;
+  uint16_t handle;
+};
+
+class BLECharacteristic {
+ public:
+  espbt::ESPBTUUID service_uuid;
+  espbt::ESPBTUUID uuid;
+  uint16_t handle;
+  std::vector<BLEDescriptor> descriptors;
+};
+
+// Host client: the GATT table is filled in by whoever plays the peripheral (see
+// tests/sim), which also delivers the GATTC events to the node.
+class BLEClient {
+ public:
+  BLECharacteristic *get_characteristic(espbt::ESPBTUUID service, espbt::ESPBTUUID chr);
+  BLEDescriptor *get_descriptor(espbt::ESPBTUUID service, espbt::ESPBTUUID chr, espbt::ESPBTUUID descr);
+
+  uint8_t *get_remote_bda() { return this->remote_bda_; }
+  uint16_t get_conn_id() const { return this->conn_id_; }
+  esp_gatt_if_t get_gattc_if() const { return this->gattc_if_; }
+  const char *address_str() const { return this->address_str_; }
+  uint64_t get_address() const { return this->address_; }
+  void set_enabled(bool enabled) { this->enabled_ = enabled; }
+  bool enabled() const { return this->enabled_; }
+
+  // Host only.
+  void set_address(uint64_t address);
+  void set_connection(esp_gatt_if_t gattc_if, uint16_t conn_id) {
+    this->gattc_if_ = gattc_if;
+    this->conn_id_ = conn_id;
+  }
+  void set_services(const std::vector<BLECharacteristic> &characteristics) {
+    this->characteristics_ = characteristics;
+  }
+  void clear_services() { this->characteristics_.clear(); }
+
+ protected:
+  std::vector<BLECharacteristic> characteristics_;
+  uint64_t address_ = 0;
+  esp_bd_addr_t remote_bda_{};
+  char address_str_[18] = "00:00:00:00:00:00";
+  uint16_t conn_id_ = 0;
+  esp_gatt_if_t gattc_if_ = 3;
+  bool enabled_ = true;
+};
+
+class BLEClientNode {
+ public:
+  virtual ~BLEClientNode() = default;
+  virtual void gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if,
+                                   esp_ble_gattc_cb_param_t *param) = 0;
+  virtual void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {}
+  BLEClient *parent() { return this->parent_; }
+  void set_ble_client_parent(BLEClient *parent) { this->parent_ = parent; }
+
+ protected:
+  BLEClient *parent_ = nullptr;
+};
+
+}  // namespace ble_client
+}  // namespace esphome
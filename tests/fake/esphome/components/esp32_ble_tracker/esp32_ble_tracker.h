@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "../../core/component.h"
+
+// The subset of the ESP-IDF Bluedroid API the neewerlight components use. The
+// GATT calls are routed to the backend installed with host::set_gatt_backend().
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef uint8_t esp_bd_addr_t[6];
+typedef uint8_t esp_gatt_if_t;
+
+typedef enum {
+  ESP_GATT_OK = 0x00,
+  ESP_GATT_INVALID_HANDLE = 0x01,
+  ESP_GATT_ERROR = 0x85,
+  ESP_GATT_TIMEOUT = 0x94,
+} esp_gatt_status_t;
+
+typedef enum {
+  ESP_GATTC_REG_EVT = 0,
+  ESP_GATTC_OPEN_EVT = 2,
+  ESP_GATTC_WRITE_CHAR_EVT = 4,
+  ESP_GATTC_CLOSE_EVT = 5,
+  ESP_GATTC_SEARCH_CMPL_EVT = 6,
+  ESP_GATTC_WRITE_DESCR_EVT = 9,
+  ESP_GATTC_NOTIFY_EVT = 10,
+  ESP_GATTC_CFG_MTU_EVT = 18,
+  ESP_GATTC_CONGEST_EVT = 24,
+  ESP_GATTC_REG_FOR_NOTIFY_EVT = 38,
+  ESP_GATTC_CONNECT_EVT = 40,
+  ESP_GATTC_DISCONNECT_EVT = 41,
+} esp_gattc_cb_event_t;
+
+typedef enum {
+  ESP_GATT_WRITE_TYPE_NO_RSP = 1,
+  ESP_GATT_WRITE_TYPE_RSP = 2,
+} esp_gatt_write_type_t;
+
+typedef enum {
+  ESP_GATT_AUTH_REQ_NONE = 0,
+} esp_gatt_auth_req_t;
+
+typedef union {
+  struct gattc_reg_evt_param {
+    esp_gatt_status_t status;
+    uint16_t app_id;
+  } reg;
+  struct gattc_open_evt_param {
+    esp_gatt_status_t status;
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+    uint16_t mtu;
+  } open;
+  struct gattc_disconnect_evt_param {
+    int reason;
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+  } disconnect;
+  struct gattc_write_evt_param {
+    esp_gatt_status_t status;
+    uint16_t conn_id;
+    uint16_t handle;
+    uint16_t offset;
+  } write;
+  struct gattc_notify_evt_param {
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+    uint16_t handle;
+    uint16_t value_len;
+    uint8_t *value;
+    bool is_notify;
+  } notify;
+  struct gattc_search_cmpl_evt_param {
+    esp_gatt_status_t status;
+    uint16_t conn_id;
+  } search_cmpl;
+  struct gattc_cfg_mtu_evt_param {
+    esp_gatt_status_t status;
+    uint16_t conn_id;
+    uint16_t mtu;
+  } cfg_mtu;
+  struct gattc_congest_evt_param {
+    uint16_t conn_id;
+    bool congested;
+  } congest;
+} esp_ble_gattc_cb_param_t;
+
+typedef enum {
+  ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT = 20,
+} esp_gap_ble_cb_event_t;
+
+typedef struct {
+  esp_bd_addr_t bda;
+  uint16_t min_int;
+  uint16_t max_int;
+  uint16_t latency;
+  uint16_t timeout;
+} esp_ble_conn_update_params_t;
+
+typedef union {
+  struct ble_update_conn_params_evt_param {
+    esp_gatt_status_t status;
+    esp_bd_addr_t bda;
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t conn_int;
+    uint16_t timeout;
+  } update_conn_params;
+} esp_ble_gap_cb_param_t;
+
+esp_err_t esp_ble_gattc_register_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t server_bda, uint16_t handle);
+esp_err_t esp_ble_gattc_write_char_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle,
+                                         uint16_t value_len, uint8_t *value, esp_gatt_write_type_t write_type,
+                                         esp_gatt_auth_req_t auth_req);
+esp_err_t esp_ble_gattc_write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len,
+                                   uint8_t *value, esp_gatt_write_type_t write_type, esp_gatt_auth_req_t auth_req);
+esp_err_t esp_ble_gattc_send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id);
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu);
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params);
+
+namespace esphome {
+namespace esp32_ble_tracker {
+
+enum class ClientState : uint8_t {
+  INIT = 0,
+  DISCONNECTING,
+  IDLE,
+  SEARCHING,
+  DISCOVERED,
+  READY_TO_CONNECT,
+  CONNECTING,
+  CONNECTED,
+  ESTABLISHED,
+};
+
+// Kept as the canonical string form; enough for lookups by UUID.
+class ESPBTUUID {
+ public:
+  static ESPBTUUID from_uint16(uint16_t uuid);
+  static ESPBTUUID from_uint32(uint32_t uuid);
+  static ESPBTUUID from_raw(const uint8_t *data);
+  static ESPBTUUID from_raw(const char *data);
+  std::string to_string() const { return this->value_; }
+  bool operator==(const ESPBTUUID &other) const { return this->value_ == other.value_; }
+
+ protected:
+  std::string value_;
+};
+
+}  // namespace esp32_ble_tracker
+}  // namespace esphome
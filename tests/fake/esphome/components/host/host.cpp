@@ -0,0 +1,194 @@
+#include "host.h"
+
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../../core/hal.h"
+#include "../../core/helpers.h"
+#include "../../core/log.h"
+#include "../../core/preferences.h"
+#include "../ble_client/ble_client.h"
+#include "../light/light_state.h"
+
+namespace esphome {
+
+namespace setup_priority {
+const float DATA = 600.0f;
+}  // namespace setup_priority
+
+static uint64_t host_time_us = 0;
+static host::GattBackend *gatt_backend = nullptr;
+static ESPPreferences host_preferences;
+ESPPreferences *global_preferences = &host_preferences;
+
+uint32_t millis() { return static_cast<uint32_t>(host_time_us / 1000); }
+uint32_t micros() { return static_cast<uint32_t>(host_time_us); }
+void delay(uint32_t ms) { host_time_us += uint64_t(ms) * 1000; }
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= static_cast<uint8_t>(c);
+  }
+  return hash;
+}
+
+namespace host {
+
+static int log_level = -1;
+
+uint64_t now_us() { return host_time_us; }
+void set_time_us(uint64_t now) { host_time_us = now; }
+void advance_us(uint64_t delta) { host_time_us += delta; }
+
+void set_log_level(int level) { log_level = level; }
+void clear_preferences() { host_preferences.clear(); }
+void set_gatt_backend(GattBackend *backend) { gatt_backend = backend; }
+
+void log(int level, const char *tag, const char *format, ...) {
+  if (log_level < 0) {
+    const char *env = getenv("NEEWER_HOST_LOG");
+    log_level = env == nullptr ? 0 : atoi(env);
+  }
+  if (level > log_level)
+    return;
+  static const char LETTERS[] = " EWICDV";
+  fprintf(stderr, "[%10.3f][%c][%s] ", host_time_us / 1000.0, LETTERS[level], tag);
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+}  // namespace host
+
+namespace esp32_ble_tracker {
+
+ESPBTUUID ESPBTUUID::from_uint16(uint16_t uuid) {
+  char buffer[7];
+  snprintf(buffer, sizeof(buffer), "0x%04X", uuid);
+  ESPBTUUID result;
+  result.value_ = buffer;
+  return result;
+}
+
+ESPBTUUID ESPBTUUID::from_uint32(uint32_t uuid) {
+  char buffer[11];
+  snprintf(buffer, sizeof(buffer), "0x%08X", uuid);
+  ESPBTUUID result;
+  result.value_ = buffer;
+  return result;
+}
+
+// 128-bit UUIDs arrive little-endian, as in esp_bt_uuid_t.
+ESPBTUUID ESPBTUUID::from_raw(const uint8_t *data) {
+  char buffer[37];
+  char *out = buffer;
+  for (int i = 15; i >= 0; i--) {
+    out += snprintf(out, 3, "%02X", data[i]);
+    if (i == 12 || i == 10 || i == 8 || i == 6)
+      *out++ = '-';
+  }
+  ESPBTUUID result;
+  result.value_ = buffer;
+  return result;
+}
+
+ESPBTUUID ESPBTUUID::from_raw(const char *data) {
+  ESPBTUUID result;
+  for (const char *c = data; *c != '\0'; c++)
+    result.value_ += static_cast<char>(toupper(static_cast<unsigned char>(*c)));
+  return result;
+}
+
+}  // namespace esp32_ble_tracker
+
+namespace ble_client {
+
+BLECharacteristic *BLEClient::get_characteristic(espbt::ESPBTUUID service, espbt::ESPBTUUID chr) {
+  for (auto &characteristic : this->characteristics_) {
+    if (characteristic.service_uuid == service && characteristic.uuid == chr)
+      return &characteristic;
+  }
+  return nullptr;
+}
+
+BLEDescriptor *BLEClient::get_descriptor(espbt::ESPBTUUID service, espbt::ESPBTUUID chr, espbt::ESPBTUUID descr) {
+  auto *characteristic = this->get_characteristic(service, chr);
+  if (characteristic == nullptr)
+    return nullptr;
+  for (auto &descriptor : characteristic->descriptors) {
+    if (descriptor.uuid == descr)
+      return &descriptor;
+  }
+  return nullptr;
+}
+
+void BLEClient::set_address(uint64_t address) {
+  this->address_ = address;
+  for (int i = 0; i < 6; i++)
+    this->remote_bda_[i] = static_cast<uint8_t>(address >> (8 * (5 - i)));
+  snprintf(this->address_str_, sizeof(this->address_str_), "%02X:%02X:%02X:%02X:%02X:%02X", this->remote_bda_[0],
+           this->remote_bda_[1], this->remote_bda_[2], this->remote_bda_[3], this->remote_bda_[4],
+           this->remote_bda_[5]);
+}
+
+}  // namespace ble_client
+
+namespace light {
+
+void LightCall::perform() {
+  this->state_->current_values.set_state(this->on_ ? 1.0f : 0.0f);
+  this->state_->note_reported_call();
+}
+
+void LightState::start_effect(LightEffect *effect) {
+  this->stop_effect();
+  this->effect_ = effect;
+  effect->init_internal(this);
+  effect->start();
+}
+
+void LightState::stop_effect() {
+  if (this->effect_ == nullptr)
+    return;
+  this->effect_->stop();
+  this->effect_ = nullptr;
+}
+
+}  // namespace light
+}  // namespace esphome
+
+using esphome::gatt_backend;
+
+esp_err_t esp_ble_gattc_register_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t server_bda, uint16_t handle) {
+  return gatt_backend == nullptr ? ESP_FAIL : gatt_backend->register_for_notify(gattc_if, server_bda, handle);
+}
+
+esp_err_t esp_ble_gattc_write_char_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle,
+                                         uint16_t value_len, uint8_t *value, esp_gatt_write_type_t write_type,
+                                         esp_gatt_auth_req_t auth_req) {
+  return gatt_backend == nullptr ? ESP_FAIL : gatt_backend->write_descr(gattc_if, conn_id, handle, value_len, value);
+}
+
+esp_err_t esp_ble_gattc_write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len,
+                                   uint8_t *value, esp_gatt_write_type_t write_type, esp_gatt_auth_req_t auth_req) {
+  return gatt_backend == nullptr ? ESP_FAIL
+                                 : gatt_backend->write_char(gattc_if, conn_id, handle, value_len, value, write_type);
+}
+
+esp_err_t esp_ble_gattc_send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id) {
+  return gatt_backend == nullptr ? ESP_FAIL : gatt_backend->send_mtu_req(gattc_if, conn_id);
+}
+
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu) {
+  return gatt_backend == nullptr ? ESP_FAIL : gatt_backend->set_local_mtu(mtu);
+}
+
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params) {
+  return gatt_backend == nullptr ? ESP_FAIL : gatt_backend->update_conn_params(*params);
+}
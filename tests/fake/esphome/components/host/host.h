@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../esp32_ble_tracker/esp32_ble_tracker.h"
+
+// Controls for the host build of the ESPHome/ESP-IDF stand-ins: the clock every
+// millis()/micros() call reads, log output, preferences, and the peripheral
+// side of the GATT calls.
+namespace esphome {
+namespace host {
+
+uint64_t now_us();
+void set_time_us(uint64_t now);
+void advance_us(uint64_t delta);
+
+void set_log_level(int level);
+void clear_preferences();
+
+// Plays the peripheral (and the local BLE stack) for the esp_ble_gatt* calls.
+class GattBackend {
+ public:
+  virtual ~GattBackend() = default;
+  virtual esp_err_t write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t length,
+                               const uint8_t *value, esp_gatt_write_type_t write_type) = 0;
+  virtual esp_err_t write_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t length,
+                                const uint8_t *value) = 0;
+  virtual esp_err_t register_for_notify(esp_gatt_if_t gattc_if, const uint8_t *bda, uint16_t handle) = 0;
+  virtual esp_err_t send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id) = 0;
+  virtual esp_err_t set_local_mtu(uint16_t mtu) = 0;
+  virtual esp_err_t update_conn_params(const esp_ble_conn_update_params_t &params) = 0;
+};
+void set_gatt_backend(GattBackend *backend);
+
+}  // namespace host
+}  // namespace esphome
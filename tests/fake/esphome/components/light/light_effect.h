@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+namespace esphome {
+namespace light {
+
+class LightState;
+
+class LightEffect {
+ public:
+  explicit LightEffect(const std::string &name) : name_(name) {}
+  virtual ~LightEffect() = default;
+  virtual void start() {}
+  virtual void stop() {}
+  virtual void apply() = 0;
+  virtual void init() {}
+  void init_internal(LightState *state) {
+    this->state_ = state;
+    this->init();
+  }
+  const std::string &get_name() const { return this->name_; }
+  LightState *get_light_state() const { return this->state_; }
+
+ protected:
+  LightState *state_ = nullptr;
+  std::string name_;
+};
+
+}  // namespace light
+}  // namespace esphome
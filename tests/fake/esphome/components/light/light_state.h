@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+
+#include "../../core/component.h"
+#include "light_effect.h"
+
+// Host LightState: no transitions or colour modes. A test sets the RGBCT values
+// the output would read and calls write_state() itself, the way LightState::loop
+// does on a device.
+namespace esphome {
+namespace light {
+
+class LightState;
+
+class LightColorValues {
+ public:
+  bool is_on() const { return this->state_ > 0.0f; }
+  float get_state() const { return this->state_; }
+  void set_state(float state) { this->state_ = state; }
+
+ protected:
+  float state_ = 0.0f;
+};
+
+class LightCall {
+ public:
+  explicit LightCall(LightState *state) : state_(state) {}
+  LightCall &set_state(bool state) {
+    this->on_ = state;
+    return *this;
+  }
+  void perform();
+
+ protected:
+  LightState *state_;
+  bool on_ = false;
+};
+
+// Only the white range; there are no colour modes on the host.
+class LightTraits {
+ public:
+  float get_min_mireds() const { return this->min_mireds_; }
+  void set_min_mireds(float min_mireds) { this->min_mireds_ = min_mireds; }
+  float get_max_mireds() const { return this->max_mireds_; }
+  void set_max_mireds(float max_mireds) { this->max_mireds_ = max_mireds; }
+
+ protected:
+  float min_mireds_ = 0.0f;
+  float max_mireds_ = 0.0f;
+};
+
+class LightOutput {
+ public:
+  virtual ~LightOutput() = default;
+  virtual LightTraits get_traits() = 0;
+  virtual void setup_state(LightState *state) {}
+  virtual void write_state(LightState *state) = 0;
+};
+
+class LightState : public EntityBase, public Component {
+ public:
+  explicit LightState(LightOutput *output) : output_(output) { this->output_->setup_state(this); }
+
+  LightCall make_call() { return LightCall(this); }
+  LightOutput *get_output() const { return this->output_; }
+  void current_values_as_rgbct(float *red, float *green, float *blue, float *color_temperature,
+                               float *white_brightness) const {
+    *red = this->red_;
+    *green = this->green_;
+    *blue = this->blue_;
+    *color_temperature = this->color_temperature_;
+    *white_brightness = this->white_brightness_;
+  }
+  bool is_transformer_active() const { return this->transformer_active_; }
+  std::string get_effect_name() const { return this->effect_ == nullptr ? "None" : this->effect_->get_name(); }
+
+  LightColorValues current_values;
+
+  // Host only.
+  void set_rgbct(bool on, float red, float green, float blue, float color_temperature, float white_brightness) {
+    this->current_values.set_state(on ? 1.0f : 0.0f);
+    this->red_ = red;
+    this->green_ = green;
+    this->blue_ = blue;
+    this->color_temperature_ = color_temperature;
+    this->white_brightness_ = white_brightness;
+  }
+  void set_transformer_active(bool active) { this->transformer_active_ = active; }
+  void start_effect(LightEffect *effect);
+  void stop_effect();
+  LightEffect *get_active_effect() const { return this->effect_; }
+  uint32_t get_reported_calls() const { return this->reported_calls_; }
+  void note_reported_call() { this->reported_calls_++; }
+
+ protected:
+  LightOutput *output_;
+  float red_ = 0.0f;
+  float green_ = 0.0f;
+  float blue_ = 0.0f;
+  float color_temperature_ = 0.0f;
+  float white_brightness_ = 0.0f;
+  bool transformer_active_ = false;
+  LightEffect *effect_ = nullptr;
+  uint32_t reported_calls_ = 0;
+};
+
+}  // namespace light
+}  // namespace esphome
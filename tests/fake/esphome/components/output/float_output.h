@@ -0,0 +1,20 @@
+#pragma once
+
+namespace esphome {
+namespace output {
+
+class BinaryOutput {
+ public:
+  virtual ~BinaryOutput() = default;
+};
+
+class FloatOutput : public BinaryOutput {
+ public:
+  void set_level(float state) { this->write_state(state); }
+
+ protected:
+  virtual void write_state(float state) = 0;
+};
+
+}  // namespace output
+}  // namespace esphome
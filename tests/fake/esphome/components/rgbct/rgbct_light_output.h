@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../light/light_state.h"
+#include "../output/float_output.h"
+
+namespace esphome {
+namespace rgbct {
+
+class RGBCTLightOutput : public light::LightOutput {
+ public:
+  void set_red(output::FloatOutput *red) { this->red_ = red; }
+  void set_green(output::FloatOutput *green) { this->green_ = green; }
+  void set_blue(output::FloatOutput *blue) { this->blue_ = blue; }
+  void set_color_temperature(output::FloatOutput *color_temperature) {
+    this->color_temperature_ = color_temperature;
+  }
+  void set_white_brightness(output::FloatOutput *white_brightness) { this->white_brightness_ = white_brightness; }
+  void set_cold_white_temperature(float temperature) { this->cold_white_temperature_ = temperature; }
+  void set_warm_white_temperature(float temperature) { this->warm_white_temperature_ = temperature; }
+  void set_color_interlock(bool color_interlock) { this->color_interlock_ = color_interlock; }
+  light::LightTraits get_traits() override {
+    light::LightTraits traits;
+    traits.set_min_mireds(this->cold_white_temperature_);
+    traits.set_max_mireds(this->warm_white_temperature_);
+    return traits;
+  }
+
+ protected:
+  output::FloatOutput *red_ = nullptr;
+  output::FloatOutput *green_ = nullptr;
+  output::FloatOutput *blue_ = nullptr;
+  output::FloatOutput *color_temperature_ = nullptr;
+  output::FloatOutput *white_brightness_ = nullptr;
+  float cold_white_temperature_ = 153.0f;
+  float warm_white_temperature_ = 500.0f;
+  bool color_interlock_ = false;
+};
+
+}  // namespace rgbct
+}  // namespace esphome
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float DATA;
+}  // namespace setup_priority
+
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+};
+
+class EntityBase {
+ public:
+  const std::string &get_name() const { return this->name_; }
+
+ protected:
+  std::string name_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Host stand-in: time comes from the simulated clock in host/host.h.
+namespace esphome {
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+}  // namespace esphome
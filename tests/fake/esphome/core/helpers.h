@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "hal.h"
+
+namespace esphome {
+
+template<typename T> T clamp(T value, T min, T max) {
+  if (value < min)
+    return min;
+  if (value > max)
+    return max;
+  return value;
+}
+
+uint32_t fnv1_hash(const std::string &str);
+
+}  // namespace esphome
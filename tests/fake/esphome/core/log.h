@@ -0,0 +1,21 @@
+#pragma once
+
+// Host logging: every level goes through esphome::host::log(), which prints
+// when the level is at or below NEEWER_HOST_LOG (0 = off, the default; 6 = verbose).
+
+namespace esphome {
+namespace host {
+
+enum LogLevel { LOG_ERROR = 1, LOG_WARN, LOG_INFO, LOG_CONFIG, LOG_DEBUG, LOG_VERBOSE };
+void log(int level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+}  // namespace host
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::host::log(::esphome::host::LOG_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::host::log(::esphome::host::LOG_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::host::log(::esphome::host::LOG_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ::esphome::host::log(::esphome::host::LOG_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::host::log(::esphome::host::LOG_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::host::log(::esphome::host::LOG_VERBOSE, tag, __VA_ARGS__)
+#define LOG_BINARY_OUTPUT(this) (void) (this)
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+// In-memory preferences; host::clear_preferences() forgets everything, like a
+// freshly flashed device.
+namespace esphome {
+
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  ESPPreferenceObject(std::map<uint32_t, std::vector<uint8_t>> *store, uint32_t key) : store_(store), key_(key) {}
+
+  template<typename T> bool save(const T *src) {
+    if (this->store_ == nullptr)
+      return false;
+    const auto *bytes = reinterpret_cast<const uint8_t *>(src);
+    (*this->store_)[this->key_].assign(bytes, bytes + sizeof(T));
+    return true;
+  }
+  template<typename T> bool load(T *dest) {
+    if (this->store_ == nullptr)
+      return false;
+    auto it = this->store_->find(this->key_);
+    if (it == this->store_->end() || it->second.size() != sizeof(T))
+      return false;
+    memcpy(dest, it->second.data(), sizeof(T));
+    return true;
+  }
+
+ protected:
+  std::map<uint32_t, std::vector<uint8_t>> *store_ = nullptr;
+  uint32_t key_ = 0;
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash = false) {
+    return ESPPreferenceObject(&this->store_, type);
+  }
+  void clear() { this->store_.clear(); }
+
+ protected:
+  std::map<uint32_t, std::vector<uint8_t>> store_;
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome
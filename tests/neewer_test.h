@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the host tests: a failed check prints where and carries
+// on, and the test exits non-zero if anything failed.
+namespace neewer_test {
+
+inline int &failures() {
+  static int count = 0;
+  return count;
+}
+
+inline int finish(const char *name) {
+  if (failures() == 0) {
+    printf("%s: all checks passed\n", name);
+    return 0;
+  }
+  printf("%s: %d check(s) failed\n", name, failures());
+  return 1;
+}
+
+}  // namespace neewer_test
+
+#define NEEWER_CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      neewer_test::failures()++; \
+    } \
+  } while (0)
+
+#define NEEWER_CHECK_EQ(actual, expected) \
+  do { \
+    const long long actual_value_ = static_cast<long long>(actual); \
+    const long long expected_value_ = static_cast<long long>(expected); \
+    if (actual_value_ != expected_value_) { \
+      printf("%s:%d: check failed: %s == %s (%lld vs %lld)\n", __FILE__, __LINE__, #actual, #expected, \
+             actual_value_, expected_value_); \
+      neewer_test::failures()++; \
+    } \
+  } while (0)
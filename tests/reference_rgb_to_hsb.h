@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// The float conversion neewer_rgb_to_hsi replaced (NeewerRGBCTLightOutput::rgb_to_hsb
+// before the fixed-point kernel), minus its logging. The host tests hold the
+// kernel to it.
+inline void reference_rgb_to_hsb(float red, float green, float blue, int *hue, uint8_t *saturation,
+                                 uint8_t *brightness) {
+  float max_value = red < green ? green : red;
+  max_value = max_value < blue ? blue : max_value;
+  float min_value = red < green ? red : green;
+  min_value = min_value < blue ? min_value : blue;
+  const float diff_value = max_value - min_value;
+
+  *brightness = (uint8_t) (max_value * 100);
+  if (max_value == 0) {
+    *saturation = 0;
+  } else {
+    *saturation = (uint8_t) ((diff_value / max_value) * 100);
+  }
+
+  if (diff_value == 0) {
+    *hue = 0;
+    return;
+  }
+  float hue_calc;
+  if (max_value == red) {
+    hue_calc = 60 * ((float) remainder(((green - blue) / diff_value), 6.0));
+  } else if (max_value == green) {
+    hue_calc = 60 * (((blue - red) / diff_value) + 2.0);
+  } else {
+    hue_calc = 60 * (((red - green) / diff_value) + 4.0);
+  }
+  *hue = (int) hue_calc;
+  if (*hue < 0)
+    *hue = *hue + 360;
+  if (*hue >= 360)
+    *hue = *hue - 360;
+}
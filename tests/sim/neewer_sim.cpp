@@ -0,0 +1,404 @@
+#include "neewer_sim.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace neewer_sim {
+
+using namespace neewerlight;
+
+static const uint8_t SIM_GATTC_IF = 3;
+
+bool SimLight::receive(const uint8_t *data, uint16_t length, NeewerPacket *reply) {
+  if (!neewer_frame_valid(data, length)) {
+    this->counters_.invalid++;
+    return false;
+  }
+  const uint8_t tag = data[1];
+  const uint8_t *payload = data + FRAME_HEADER_SIZE;
+  uint8_t payload_length = data[2];
+
+  // Infinity framing: MAC, then the classic tag as subtag.
+  uint8_t classic_tag = tag;
+  switch (tag) {
+    case INFINITY_POWER_TAG:
+    case INFINITY_HSI_TAG:
+    case INFINITY_CCT_TAG:
+    case INFINITY_FX_TAG: {
+      if (payload_length < MAC_ADDRESS_SIZE + 1) {
+        this->counters_.invalid++;
+        return false;
+      }
+      uint64_t address = 0;
+      for (uint8_t i = 0; i < MAC_ADDRESS_SIZE; i++)
+        address = (address << 8) | payload[i];
+      if (address != this->mac_) {
+        this->counters_.invalid++;
+        return false;
+      }
+      classic_tag = payload[MAC_ADDRESS_SIZE];
+      payload += MAC_ADDRESS_SIZE + 1;
+      payload_length -= MAC_ADDRESS_SIZE + 1;
+      break;
+    }
+    default:
+      break;
+  }
+  return this->apply_(classic_tag, payload, payload_length, reply);
+}
+
+bool SimLight::apply_(uint8_t tag, const uint8_t *payload, uint8_t length, NeewerPacket *reply) {
+  auto &panel = this->panel_;
+  switch (tag) {
+    case POWER_TAG:
+      if (length < 1)
+        break;
+      this->counters_.power++;
+      panel.on = payload[0] == POWER_ON;
+      return false;
+    case HSI_TAG:
+      if (length < 4)
+        break;
+      this->counters_.hsi++;
+      panel.mode = SimMode::HSI;
+      panel.hue = payload[0] | (payload[1] << 8);
+      panel.saturation = payload[2];
+      panel.brightness = payload[3];
+      return false;
+    case CCT_TAG:
+      if (length < 2)
+        break;
+      this->counters_.cct++;
+      panel.mode = SimMode::CCT;
+      panel.brightness = payload[0];
+      panel.cct = payload[1];
+      panel.gm = length > 2 ? payload[2] : 0;
+      return false;
+    case FX_SUBTAG:
+      if (length < 1)
+        break;
+      this->counters_.fx++;
+      panel.mode = SimMode::SCENE;
+      panel.scene = payload[0];
+      panel.scene_param_count = std::min<uint8_t>(length - 1, sizeof(panel.scene_params));
+      memcpy(panel.scene_params, payload + 1, panel.scene_param_count);
+      return false;
+    case POWER_STATUS_REQUEST_TAG:
+      this->counters_.power_status++;
+      reply->begin(POWER_STATUS_RESPONSE_TAG);
+      reply->append(panel.on ? POWER_ON : POWER_STANDBY);
+      reply->finish();
+      return true;
+    case CHANNEL_STATUS_REQUEST_TAG:
+      this->counters_.channel_status++;
+      reply->begin(CHANNEL_STATUS_RESPONSE_TAG);
+      reply->append(panel.channel);
+      reply->finish();
+      return true;
+    default:
+      break;
+  }
+  this->counters_.invalid++;
+  return false;
+}
+
+SimLink::SimLink(SimWorld *world, NeewerBLEOutput *output, uint64_t mac, uint16_t conn_id,
+                 const SimLightConfig &config)
+    : world_(world), output_(output), light_(mac), config_(config), conn_id_(conn_id), random_(config.seed) {
+  this->client_.set_address(mac);
+  this->client_.set_connection(SIM_GATTC_IF, conn_id);
+  output->set_ble_client_parent(&this->client_);
+  // ble_client registers its GATT client app once the stack is up, long before it connects.
+  esp_ble_gattc_cb_param_t reg{};
+  reg.reg.status = ESP_GATT_OK;
+  reg.reg.app_id = conn_id;
+  world->schedule_(this, 0, ESP_GATTC_REG_EVT, reg);
+}
+
+void SimLink::connect() {
+  if (this->connected_)
+    return;
+  this->connected_ = true;
+  this->granted_mtu_ = 23;
+  esp_ble_gattc_cb_param_t param{};
+  param.open.status = ESP_GATT_OK;
+  param.open.conn_id = this->conn_id_;
+  memcpy(param.open.remote_bda, this->client_.get_remote_bda(), sizeof(esp_bd_addr_t));
+  param.open.mtu = 23;
+  this->world_->schedule_(this, 0, ESP_GATTC_OPEN_EVT, param);
+  // BLEClientBase starts the MTU exchange itself on every connection.
+  this->send_mtu_req_();
+
+  // Discovery fills in the GATT table just before SEARCH_CMPL is delivered.
+  esp_ble_gattc_cb_param_t search{};
+  search.search_cmpl.status = ESP_GATT_OK;
+  search.search_cmpl.conn_id = this->conn_id_;
+  this->world_->schedule_(this, this->config_.discovery_ms, ESP_GATTC_SEARCH_CMPL_EVT, search);
+}
+
+void SimLink::disconnect() {
+  if (!this->connected_)
+    return;
+  this->connected_ = false;
+  this->generation_++;
+  this->client_.clear_services();
+  esp_ble_gattc_cb_param_t param{};
+  param.disconnect.reason = 0x13;
+  param.disconnect.conn_id = this->conn_id_;
+  memcpy(param.disconnect.remote_bda, this->client_.get_remote_bda(), sizeof(esp_bd_addr_t));
+  this->world_->schedule_(this, 0, ESP_GATTC_DISCONNECT_EVT, param);
+}
+
+bool SimLink::roll_loss_() {
+  if (this->config_.loss <= 0.0f)
+    return false;
+  // xorshift32: reproducible per seed.
+  this->random_ ^= this->random_ << 13;
+  this->random_ ^= this->random_ >> 17;
+  this->random_ ^= this->random_ << 5;
+  return (this->random_ % 10000) < static_cast<uint32_t>(this->config_.loss * 10000.0f);
+}
+
+esp_err_t SimLink::write_char_(uint16_t handle, const uint8_t *value, uint16_t length,
+                               esp_gatt_write_type_t write_type) {
+  if (!this->connected_)
+    return ESP_FAIL;
+  auto &counters = this->light_.counters();
+  counters.writes++;
+  counters.bytes += length;
+  if (write_type == ESP_GATT_WRITE_TYPE_RSP)
+    counters.writes_rsp++;
+  else
+    counters.writes_no_rsp++;
+
+  esp_ble_gattc_cb_param_t param{};
+  param.write.conn_id = this->conn_id_;
+  param.write.handle = handle;
+  if (handle != SIM_WRITE_HANDLE) {
+    param.write.status = ESP_GATT_INVALID_HANDLE;
+    this->schedule_write_event_(this->config_.ack_latency_ms, param);
+    return ESP_OK;
+  }
+
+  const bool no_rsp = write_type == ESP_GATT_WRITE_TYPE_NO_RSP;
+  // A write command completes locally once it leaves the controller, whatever
+  // happens to it afterwards.
+  param.write.status = ESP_GATT_OK;
+  if (no_rsp)
+    this->schedule_write_event_(this->config_.no_rsp_latency_ms, param);
+
+  if (this->roll_loss_()) {
+    counters.lost++;
+    return ESP_OK;
+  }
+  if (this->unresponsive_) {
+    counters.ignored++;
+    return ESP_OK;
+  }
+  if (!no_rsp)
+    this->schedule_write_event_(this->config_.ack_latency_ms, param);
+
+  NeewerPacket reply;
+  if (this->light_.receive(value, length, &reply)) {
+    esp_ble_gattc_cb_param_t notify{};
+    notify.notify.conn_id = this->conn_id_;
+    memcpy(notify.notify.remote_bda, this->client_.get_remote_bda(), sizeof(esp_bd_addr_t));
+    notify.notify.handle = SIM_NOTIFY_HANDLE;
+    notify.notify.is_notify = true;
+    counters.notifies++;
+    this->world_->schedule_(this, this->config_.notify_latency_ms, ESP_GATTC_NOTIFY_EVT, notify, reply.data(),
+                            reply.size());
+  }
+  return ESP_OK;
+}
+
+// Like the real stack, a connection's writes complete in the order they were made,
+// even when a later one would be quicker on its own.
+void SimLink::schedule_write_event_(uint32_t delay_ms, const esp_ble_gattc_cb_param_t &param) {
+  const uint64_t now = host::now_us();
+  const uint64_t due = std::max(now + uint64_t(delay_ms) * 1000, this->last_write_event_us_);
+  this->last_write_event_us_ = due;
+  this->world_->schedule_(this, static_cast<uint32_t>((due - now) / 1000), ESP_GATTC_WRITE_CHAR_EVT, param);
+}
+
+esp_err_t SimLink::write_descr_(uint16_t handle, const uint8_t *value, uint16_t length) {
+  if (!this->connected_)
+    return ESP_FAIL;
+  this->light_.counters().cccd_writes++;
+  esp_ble_gattc_cb_param_t param{};
+  param.write.conn_id = this->conn_id_;
+  param.write.handle = handle;
+  param.write.status = handle == SIM_CCCD_HANDLE ? ESP_GATT_OK : ESP_GATT_INVALID_HANDLE;
+  this->world_->schedule_(this, this->config_.ack_latency_ms, ESP_GATTC_WRITE_DESCR_EVT, param);
+  return ESP_OK;
+}
+
+esp_err_t SimLink::send_mtu_req_() {
+  if (!this->connected_)
+    return ESP_FAIL;
+  this->light_.counters().mtu_requests++;
+  esp_ble_gattc_cb_param_t param{};
+  param.cfg_mtu.status = ESP_GATT_OK;
+  param.cfg_mtu.conn_id = this->conn_id_;
+  param.cfg_mtu.mtu = std::min(this->world_->get_local_mtu(), SIM_PEER_MTU);
+  this->world_->schedule_(this, this->config_.ack_latency_ms, ESP_GATTC_CFG_MTU_EVT, param);
+  return ESP_OK;
+}
+
+SimWorld::SimWorld() {
+  host::set_time_us(1000000);
+  host::clear_preferences();
+  host::set_gatt_backend(this);
+}
+
+SimWorld::~SimWorld() { host::set_gatt_backend(nullptr); }
+
+SimLink &SimWorld::add_light(NeewerBLEOutput *output, uint64_t mac, const SimLightConfig &config) {
+  const uint16_t conn_id = static_cast<uint16_t>(this->links_.size());
+  this->links_.emplace_back(new SimLink(this, output, mac, conn_id, config));
+  return *this->links_.back();
+}
+
+void SimWorld::step() {
+  host::advance_us(1000);
+  const uint64_t now = host::now_us();
+  for (;;) {
+    auto next = this->events_.end();
+    for (auto it = this->events_.begin(); it != this->events_.end(); ++it) {
+      if (it->due_us <= now && (next == this->events_.end() || it->due_us < next->due_us ||
+                                (it->due_us == next->due_us && it->order < next->order)))
+        next = it;
+    }
+    if (next == this->events_.end())
+      break;
+    Event event = std::move(*next);
+    this->events_.erase(next);
+    this->deliver_(event);
+  }
+  for (auto &link : this->links_)
+    static_cast<Component *>(link->output_)->loop();
+  for (auto &loop : this->loops_)
+    loop();
+}
+
+void SimWorld::run_for(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; i++)
+    this->step();
+}
+
+bool SimWorld::run_until(const std::function<bool()> &done, uint32_t timeout_ms) {
+  for (uint32_t i = 0; i < timeout_ms; i++) {
+    if (done())
+      return true;
+    this->step();
+  }
+  return done();
+}
+
+void SimWorld::schedule_(SimLink *link, uint32_t delay_ms, esp_gattc_cb_event_t event,
+                         const esp_ble_gattc_cb_param_t &param, const uint8_t *value, uint16_t length) {
+  Event entry{};
+  entry.due_us = host::now_us() + uint64_t(delay_ms) * 1000;
+  entry.order = this->next_order_++;
+  entry.link = link;
+  entry.kind = EventKind::GATTC;
+  entry.gattc_event = event;
+  entry.gattc_param = param;
+  if (value != nullptr)
+    entry.value.assign(value, value + length);
+  entry.generation = link->generation_;
+  this->events_.push_back(std::move(entry));
+}
+
+void SimWorld::schedule_gap_(SimLink *link, uint32_t delay_ms, const esp_ble_gap_cb_param_t &param) {
+  Event entry{};
+  entry.due_us = host::now_us() + uint64_t(delay_ms) * 1000;
+  entry.order = this->next_order_++;
+  entry.link = link;
+  entry.kind = EventKind::GAP;
+  entry.gap_param = param;
+  entry.generation = link->generation_;
+  this->events_.push_back(std::move(entry));
+}
+
+void SimWorld::deliver_(Event &event) {
+  SimLink *link = event.link;
+  if (event.generation != link->generation_)
+    return;
+  if (event.kind == EventKind::GAP) {
+    link->output_->gap_event_handler(ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT, &event.gap_param);
+    return;
+  }
+  if (event.gattc_event == ESP_GATTC_SEARCH_CMPL_EVT) {
+    ble_client::BLECharacteristic write_chr;
+    write_chr.service_uuid = espbt::ESPBTUUID::from_raw(SERVICE_UUID);
+    write_chr.uuid = espbt::ESPBTUUID::from_raw(CHARACTERISTIC_UUID);
+    write_chr.handle = SIM_WRITE_HANDLE;
+    ble_client::BLECharacteristic notify_chr;
+    notify_chr.service_uuid = espbt::ESPBTUUID::from_raw(SERVICE_UUID);
+    notify_chr.uuid = espbt::ESPBTUUID::from_raw(NOTIFY_CHARACTERISTIC_UUID);
+    notify_chr.handle = SIM_NOTIFY_HANDLE;
+    notify_chr.descriptors.push_back({espbt::ESPBTUUID::from_uint16(0x2902), SIM_CCCD_HANDLE});
+    link->client_.set_services({write_chr, notify_chr});
+  } else if (event.gattc_event == ESP_GATTC_CFG_MTU_EVT) {
+    link->granted_mtu_ = event.gattc_param.cfg_mtu.mtu;
+  } else if (event.gattc_event == ESP_GATTC_NOTIFY_EVT) {
+    event.gattc_param.notify.value = event.value.data();
+    event.gattc_param.notify.value_len = static_cast<uint16_t>(event.value.size());
+  }
+  link->output_->gattc_event_handler(event.gattc_event, SIM_GATTC_IF, &event.gattc_param);
+}
+
+SimLink *SimWorld::find_(uint16_t conn_id) {
+  return conn_id < this->links_.size() ? this->links_[conn_id].get() : nullptr;
+}
+
+esp_err_t SimWorld::write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t length,
+                               const uint8_t *value, esp_gatt_write_type_t write_type) {
+  SimLink *link = this->find_(conn_id);
+  return link == nullptr ? ESP_FAIL : link->write_char_(handle, value, length, write_type);
+}
+
+esp_err_t SimWorld::write_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t length,
+                                const uint8_t *value) {
+  SimLink *link = this->find_(conn_id);
+  return link == nullptr ? ESP_FAIL : link->write_descr_(handle, value, length);
+}
+
+esp_err_t SimWorld::register_for_notify(esp_gatt_if_t gattc_if, const uint8_t *bda, uint16_t handle) {
+  return ESP_OK;
+}
+
+esp_err_t SimWorld::send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id) {
+  SimLink *link = this->find_(conn_id);
+  return link == nullptr ? ESP_FAIL : link->send_mtu_req_();
+}
+
+esp_err_t SimWorld::set_local_mtu(uint16_t mtu) {
+  this->local_mtu_ = mtu;
+  this->local_mtu_sets_++;
+  return ESP_OK;
+}
+
+// The light grants whatever was asked for, at the top of the range.
+esp_err_t SimWorld::update_conn_params(const esp_ble_conn_update_params_t &params) {
+  for (auto &link : this->links_) {
+    if (memcmp(link->client_.get_remote_bda(), params.bda, sizeof(esp_bd_addr_t)) != 0)
+      continue;
+    esp_ble_gap_cb_param_t param{};
+    param.update_conn_params.status = ESP_GATT_OK;
+    memcpy(param.update_conn_params.bda, params.bda, sizeof(esp_bd_addr_t));
+    param.update_conn_params.min_int = params.min_int;
+    param.update_conn_params.max_int = params.max_int;
+    param.update_conn_params.latency = params.latency;
+    param.update_conn_params.conn_int = params.max_int;
+    param.update_conn_params.timeout = params.timeout;
+    this->schedule_gap_(link.get(), link->config_.ack_latency_ms, param);
+    return ESP_OK;
+  }
+  return ESP_FAIL;
+}
+
+}  // namespace neewer_sim
+}  // namespace esphome
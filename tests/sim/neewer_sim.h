@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "../../components/neewerlight/neewer_light_output.h"
+#include "../fake/esphome/components/host/host.h"
+
+// A simulated Neewer light on the far end of the fake GATT client. The world
+// owns the clock: every step delivers the GATT events that have fallen due and
+// then runs each output's loop(), the way ESPHome's main loop would.
+namespace esphome {
+namespace neewer_sim {
+
+using neewerlight::NeewerBLEOutput;
+using neewerlight::NeewerPacket;
+
+// GATT table of the simulated light.
+static const uint16_t SIM_WRITE_HANDLE = 0x000E;
+static const uint16_t SIM_NOTIFY_HANDLE = 0x0011;
+static const uint16_t SIM_CCCD_HANDLE = 0x0012;
+static const uint16_t SIM_PEER_MTU = 185;
+
+struct SimLightConfig {
+    uint32_t ack_latency_ms = 30;      // write request to write response
+    uint32_t no_rsp_latency_ms = 8;    // write command leaves the controller (about one connection event)
+    uint32_t notify_latency_ms = 30;   // status request received to status notify
+    uint32_t discovery_ms = 600;       // connection open to service discovery complete
+    float loss = 0.0f;                 // chance that a write never reaches the light
+    uint32_t seed = 1;
+};
+
+enum class SimMode : uint8_t {
+    NONE = 0,
+    HSI,
+    CCT,
+    SCENE,
+};
+
+// What the panel shows.
+struct SimPanel {
+    bool on = false;
+    SimMode mode = SimMode::NONE;
+    uint16_t hue = 0;
+    uint8_t saturation = 0;
+    uint8_t brightness = 0;
+    uint8_t cct = 0;
+    uint8_t gm = 0;
+    uint8_t scene = 0;
+    uint8_t scene_params[8] = {};
+    uint8_t scene_param_count = 0;
+    uint8_t channel = 1;
+};
+
+struct SimCounters {
+    uint32_t writes = 0;          // everything handed to esp_ble_gattc_write_char
+    uint32_t writes_rsp = 0;
+    uint32_t writes_no_rsp = 0;
+    uint32_t bytes = 0;
+    uint32_t lost = 0;            // dropped by the configured loss
+    uint32_t ignored = 0;         // arrived while unresponsive
+    uint32_t invalid = 0;         // failed neewer_frame_valid, or addressed to another MAC
+    uint32_t power = 0;
+    uint32_t hsi = 0;
+    uint32_t cct = 0;
+    uint32_t fx = 0;
+    uint32_t power_status = 0;
+    uint32_t channel_status = 0;
+    uint32_t notifies = 0;
+    uint32_t mtu_requests = 0;
+    uint32_t cccd_writes = 0;
+};
+
+// The light itself: parses frames, keeps its panel state and builds replies.
+class SimLight {
+ public:
+    explicit SimLight(uint64_t mac) : mac_(mac) {}
+
+    // Apply one written frame. Returns true and fills reply when the light answers
+    // on the notify characteristic.
+    bool receive(const uint8_t *data, uint16_t length, NeewerPacket *reply);
+
+    const SimPanel &panel() const { return this->panel_; }
+    SimPanel &panel() { return this->panel_; }
+    SimCounters &counters() { return this->counters_; }
+    const SimCounters &counters() const { return this->counters_; }
+
+ protected:
+    bool apply_(uint8_t tag, const uint8_t *payload, uint8_t length, NeewerPacket *reply);
+
+    uint64_t mac_;
+    SimPanel panel_;
+    SimCounters counters_;
+};
+
+class SimWorld;
+
+// One connection: the fake BLEClient the output talks through, and the light.
+class SimLink {
+ public:
+    SimLink(SimWorld *world, NeewerBLEOutput *output, uint64_t mac, uint16_t conn_id, const SimLightConfig &config);
+
+    void connect();
+    void disconnect();
+    bool connected() const { return this->connected_; }
+
+    // Overwhelmed: acknowledged writes and status requests get no answer, writes
+    // without response still leave the controller but change nothing.
+    void set_unresponsive(bool unresponsive) { this->unresponsive_ = unresponsive; }
+    void set_loss(float loss) { this->config_.loss = loss; }
+    void set_ack_latency(uint32_t latency_ms) { this->config_.ack_latency_ms = latency_ms; }
+    // Time for a write without response to leave the controller; a congested radio takes longer.
+    void set_no_rsp_latency(uint32_t latency_ms) { this->config_.no_rsp_latency_ms = latency_ms; }
+
+    SimLight &light() { return this->light_; }
+    ble_client::BLEClient &client() { return this->client_; }
+    NeewerBLEOutput *output() { return this->output_; }
+    uint16_t conn_id() const { return this->conn_id_; }
+    uint16_t granted_mtu() const { return this->granted_mtu_; }
+
+ protected:
+    friend class SimWorld;
+
+    esp_err_t write_char_(uint16_t handle, const uint8_t *value, uint16_t length, esp_gatt_write_type_t write_type);
+    esp_err_t write_descr_(uint16_t handle, const uint8_t *value, uint16_t length);
+    esp_err_t send_mtu_req_();
+    bool roll_loss_();
+    void schedule_write_event_(uint32_t delay_ms, const esp_ble_gattc_cb_param_t &param);
+
+    SimWorld *world_;
+    NeewerBLEOutput *output_;
+    ble_client::BLEClient client_;
+    SimLight light_;
+    SimLightConfig config_;
+    uint16_t conn_id_;
+    bool connected_ = false;
+    bool unresponsive_ = false;
+    uint16_t granted_mtu_ = 23;
+    uint32_t generation_ = 0;  // bumped on disconnect; older events are dropped
+    uint64_t last_write_event_us_ = 0;
+    uint32_t random_;
+};
+
+class SimWorld : public host::GattBackend {
+ public:
+    SimWorld();
+    ~SimWorld() override;
+
+    SimLink &add_light(NeewerBLEOutput *output, uint64_t mac, const SimLightConfig &config = SimLightConfig());
+    // Extra components to run every step (effects, pools).
+    void add_loop(std::function<void()> loop) { this->loops_.push_back(std::move(loop)); }
+
+    void step();  // one millisecond
+    void run_for(uint32_t ms);
+    bool run_until(const std::function<bool()> &done, uint32_t timeout_ms);
+
+    uint32_t get_local_mtu_sets() const { return this->local_mtu_sets_; }
+    uint16_t get_local_mtu() const { return this->local_mtu_; }
+
+    // host::GattBackend
+    esp_err_t write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t length,
+                         const uint8_t *value, esp_gatt_write_type_t write_type) override;
+    esp_err_t write_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t length,
+                          const uint8_t *value) override;
+    esp_err_t register_for_notify(esp_gatt_if_t gattc_if, const uint8_t *bda, uint16_t handle) override;
+    esp_err_t send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id) override;
+    esp_err_t set_local_mtu(uint16_t mtu) override;
+    esp_err_t update_conn_params(const esp_ble_conn_update_params_t &params) override;
+
+ protected:
+    friend class SimLink;
+
+    enum class EventKind : uint8_t { GATTC, GAP };
+    struct Event {
+      uint64_t due_us;
+      uint64_t order;
+      SimLink *link;
+      EventKind kind;
+      esp_gattc_cb_event_t gattc_event;
+      esp_ble_gattc_cb_param_t gattc_param;
+      esp_ble_gap_cb_param_t gap_param;
+      std::vector<uint8_t> value;  // notify payload
+      uint32_t generation;
+    };
+
+    void schedule_(SimLink *link, uint32_t delay_ms, esp_gattc_cb_event_t event, const esp_ble_gattc_cb_param_t &param,
+                   const uint8_t *value = nullptr, uint16_t length = 0);
+    void schedule_gap_(SimLink *link, uint32_t delay_ms, const esp_ble_gap_cb_param_t &param);
+    void deliver_(Event &event);
+    SimLink *find_(uint16_t conn_id);
+
+    std::vector<std::unique_ptr<SimLink>> links_;
+    std::deque<Event> events_;
+    std::vector<std::function<void()>> loops_;
+    uint64_t next_order_ = 0;
+    uint16_t local_mtu_ = 23;
+    uint32_t local_mtu_sets_ = 0;
+};
+
+}  // namespace neewer_sim
+}  // namespace esphome
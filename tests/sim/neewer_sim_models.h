@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../../components/neewerlight/neewer_model.h"
+
+// The traits structs light.py generates from models.json for the models the
+// host tests use. Keep in step with _model_traits_cpp() and _scene_set_cpp().
+namespace esphome {
+namespace neewerlight {
+struct NeewerRgb660Model {
+  static constexpr const char *NAME = "rgb660";
+  static constexpr float KELVIN_MIN = 3200.0f;
+  static constexpr float KELVIN_MAX = 5600.0f;
+  static constexpr bool CCT_IN_KELVIN = false;
+  static constexpr bool HAS_GM = false;
+  static constexpr const uint8_t *CCT_TRAILER = nullptr;
+  static constexpr uint8_t CCT_TRAILER_SIZE = 0;
+  static constexpr bool MAC_PREFIXED = false;
+  static constexpr const NeewerSceneDefinition *SCENES = nullptr;
+  static constexpr uint8_t SCENE_COUNT = 0;
+  static constexpr uint8_t SCENE_CCT_MIN = 0;
+  static constexpr uint8_t SCENE_CCT_MAX = 0;
+  static constexpr uint8_t MAX_FRAME_SIZE = 8;
+};
+}  // namespace neewerlight
+}  // namespace esphome
+namespace esphome {
+namespace neewerlight {
+static constexpr NeewerSceneDefinition NEEWER_FX9_SCENES[] = {
+    neewer_scene(1, "Lighting", NeewerSceneByte::BRR, NeewerSceneByte::CCT, NeewerSceneByte::SPEED),
+    neewer_scene(2, "Paparazzi", NeewerSceneByte::BRR, NeewerSceneByte::CCT, NeewerSceneByte::GM, NeewerSceneByte::SPEED),
+    neewer_scene(3, "Defective Bulb", NeewerSceneByte::BRR, NeewerSceneByte::CCT, NeewerSceneByte::GM, NeewerSceneByte::SPEED),
+    neewer_scene(4, "Explosion", NeewerSceneByte::BRR, NeewerSceneByte::CCT, NeewerSceneByte::GM, NeewerSceneByte::SPEED, NeewerSceneByte::SPARKS),
+    neewer_scene(5, "Welding", NeewerSceneByte::BRR, NeewerSceneByte::CCT, NeewerSceneByte::GM, NeewerSceneByte::SPEED),
+    neewer_scene(6, "CCT Flash", NeewerSceneByte::BRR, NeewerSceneByte::CCT, NeewerSceneByte::GM, NeewerSceneByte::SPEED),
+    neewer_scene(7, "Hue Flash", NeewerSceneByte::BRR, NeewerSceneByte::HUE_LSB, NeewerSceneByte::HUE_MSB, NeewerSceneByte::SAT, NeewerSceneByte::SPEED),
+    neewer_scene(8, "CCT Pulse", NeewerSceneByte::BRR, NeewerSceneByte::CCT, NeewerSceneByte::GM, NeewerSceneByte::SPEED),
+    neewer_scene(9, "Hue Pulse", NeewerSceneByte::BRR, NeewerSceneByte::HUE_LSB, NeewerSceneByte::HUE_MSB, NeewerSceneByte::SAT, NeewerSceneByte::SPEED),
+};
+static constexpr uint8_t NEEWER_RGB62_CCT_TRAILER[] = {0x00, 0x00};
+struct NeewerRgb62Model {
+  static constexpr const char *NAME = "rgb62";
+  static constexpr float KELVIN_MIN = 2500.0f;
+  static constexpr float KELVIN_MAX = 8500.0f;
+  static constexpr bool CCT_IN_KELVIN = true;
+  static constexpr bool HAS_GM = true;
+  static constexpr const uint8_t *CCT_TRAILER = NEEWER_RGB62_CCT_TRAILER;
+  static constexpr uint8_t CCT_TRAILER_SIZE = 2;
+  static constexpr bool MAC_PREFIXED = false;
+  static constexpr const NeewerSceneDefinition *SCENES = NEEWER_FX9_SCENES;
+  static constexpr uint8_t SCENE_COUNT = 9;
+  static constexpr uint8_t SCENE_CCT_MIN = 29;
+  static constexpr uint8_t SCENE_CCT_MAX = 70;
+  static constexpr uint8_t MAX_FRAME_SIZE = 10;
+};
+}  // namespace neewerlight
+}  // namespace esphome
+namespace esphome {
+namespace neewerlight {
+static constexpr uint8_t NEEWER_INFINITY_CCT_TRAILER[] = {0x04};
+struct NeewerInfinityModel {
+  static constexpr const char *NAME = "infinity";
+  static constexpr float KELVIN_MIN = 2500.0f;
+  static constexpr float KELVIN_MAX = 10000.0f;
+  static constexpr bool CCT_IN_KELVIN = true;
+  static constexpr bool HAS_GM = true;
+  static constexpr const uint8_t *CCT_TRAILER = NEEWER_INFINITY_CCT_TRAILER;
+  static constexpr uint8_t CCT_TRAILER_SIZE = 1;
+  static constexpr bool MAC_PREFIXED = true;
+  static constexpr const NeewerSceneDefinition *SCENES = NEEWER_FX9_SCENES;
+  static constexpr uint8_t SCENE_COUNT = 9;
+  static constexpr uint8_t SCENE_CCT_MIN = 29;
+  static constexpr uint8_t SCENE_CCT_MAX = 70;
+  static constexpr uint8_t MAX_FRAME_SIZE = 17;
+};
+}  // namespace neewerlight
+}  // namespace esphome
@@ -0,0 +1,59 @@
+// neewer_rgb_to_hsi against the float conversion it replaced, over the whole
+// 8-bit RGB cube: every hue, saturation and brightness byte within 1 LSB.
+
+#include <cstdlib>
+
+#include "../components/neewerlight/neewer_color.h"
+#include "neewer_test.h"
+#include "reference_rgb_to_hsb.h"
+
+using esphome::neewerlight::neewer_rgb_to_hsi;
+
+int main() {
+  uint32_t checked = 0;
+  uint32_t exact = 0;
+  int worst_hue = 0;
+  int worst_saturation = 0;
+  int worst_brightness = 0;
+  for (int r = 0; r < 256; r++) {
+    for (int g = 0; g < 256; g++) {
+      for (int b = 0; b < 256; b++) {
+        const float red = r / 255.0f;
+        const float green = g / 255.0f;
+        const float blue = b / 255.0f;
+        int expected_hue;
+        uint8_t expected_saturation;
+        uint8_t expected_brightness;
+        reference_rgb_to_hsb(red, green, blue, &expected_hue, &expected_saturation, &expected_brightness);
+        uint16_t hue;
+        uint8_t saturation;
+        uint8_t brightness;
+        neewer_rgb_to_hsi(red, green, blue, &hue, &saturation, &brightness);
+
+        // Hue wraps: 359 and 0 are one step apart.
+        int hue_error = abs(int(hue) - expected_hue);
+        if (hue_error > 180)
+          hue_error = 360 - hue_error;
+        const int saturation_error = abs(int(saturation) - int(expected_saturation));
+        const int brightness_error = abs(int(brightness) - int(expected_brightness));
+        if (hue_error > 1 || saturation_error > 1 || brightness_error > 1 || hue >= 360) {
+          if (neewer_test::failures() < 10) {
+            printf("RGB(%d,%d,%d): got H%u S%u B%u, float gave H%d S%u B%u\n", r, g, b, hue, saturation, brightness,
+                   expected_hue, expected_saturation, expected_brightness);
+          }
+          neewer_test::failures()++;
+        }
+        worst_hue = std::max(worst_hue, hue_error);
+        worst_saturation = std::max(worst_saturation, saturation_error);
+        worst_brightness = std::max(worst_brightness, brightness_error);
+        if (hue_error == 0 && saturation_error == 0 && brightness_error == 0)
+          exact++;
+        checked++;
+      }
+    }
+  }
+  NEEWER_CHECK_EQ(checked, 256 * 256 * 256);
+  printf("%u colours, %u identical to the float conversion, max error H%d S%d B%d\n", checked, exact, worst_hue,
+         worst_saturation, worst_brightness);
+  return neewer_test::finish("test_color");
+}
@@ -0,0 +1,134 @@
+// Snapping a target onto the device grid and encoding it must agree: the byte
+// the snap rounded to is the byte that goes on the wire, and a target already on
+// the grid encodes unchanged. Covers every 8-bit level Home Assistant can send.
+
+#include <cmath>
+#include <cstdlib>
+
+#include "neewer_test.h"
+#include "sim/neewer_sim_models.h"
+
+using namespace esphome::neewerlight;
+
+// Classic frames: brightness is payload byte 0 in CCT frames and byte 3 in HSI frames.
+static const uint8_t CCT_BRIGHTNESS = FRAME_HEADER_SIZE;
+static const uint8_t CCT_BYTE = FRAME_HEADER_SIZE + 1;
+static const uint8_t HSI_BRIGHTNESS = FRAME_HEADER_SIZE + 3;
+
+static uint8_t percent_byte(double fraction) {
+  const long percent = lround(fraction * 100.0);
+  return static_cast<uint8_t>(fraction > 0.0 && percent < 1 ? 1 : percent);
+}
+
+// Encode a target, then encode the target as snapped again. The bytes the snap
+// decides (brightness, CCT) must come out the same. Hue and saturation aren't
+// snapped; rescaling the colour may move them across an exact step (a colour
+// whose hue is exactly 20 degrees), so they only have to stay within 1 LSB.
+template<typename Output>
+static NeewerPacket encode_twice(Output &output, NeewerLightTarget target, NeewerLightTarget *snapped) {
+  output.encode_target(&target);
+  const NeewerPacket frame = output.get_encoded_frame();
+  *snapped = target;
+  output.encode_target(&target);
+  const NeewerPacket &again = output.get_encoded_frame();
+  NEEWER_CHECK_EQ(again.size(), frame.size());
+  NEEWER_CHECK_EQ(again.tag(), frame.tag());
+  if (frame.tag() == CCT_TAG) {
+    NEEWER_CHECK(again == frame);
+  } else if (frame.tag() == HSI_TAG) {
+    const int hue = frame.data()[FRAME_HEADER_SIZE] | (frame.data()[FRAME_HEADER_SIZE + 1] << 8);
+    const int hue_again = again.data()[FRAME_HEADER_SIZE] | (again.data()[FRAME_HEADER_SIZE + 1] << 8);
+    const int hue_error = abs(hue - hue_again);
+    NEEWER_CHECK(hue_error <= 1 || hue_error == 359);
+    NEEWER_CHECK(abs(frame.data()[FRAME_HEADER_SIZE + 2] - again.data()[FRAME_HEADER_SIZE + 2]) <= 1);
+    NEEWER_CHECK_EQ(again.data()[HSI_BRIGHTNESS], frame.data()[HSI_BRIGHTNESS]);
+  }
+  return frame;
+}
+
+template<typename Output> static void check_white(Output &output) {
+  for (int level = 1; level < 256; level++) {
+    NeewerLightTarget target;
+    target.on = true;
+    target.color_temperature = 0.5f;
+    target.white_brightness = level / 255.0f;
+    NeewerLightTarget snapped;
+    const NeewerPacket frame = encode_twice(output, target, &snapped);
+    NEEWER_CHECK_EQ(frame.tag(), CCT_TAG);
+    NEEWER_CHECK_EQ(frame.data()[CCT_BRIGHTNESS], percent_byte(level / 255.0));
+    NEEWER_CHECK_EQ(frame.data()[CCT_BRIGHTNESS], lroundf(snapped.white_brightness * 100.0f));
+  }
+  for (int percent = 1; percent <= 100; percent++) {
+    NeewerLightTarget target;
+    target.on = true;
+    target.color_temperature = 0.5f;
+    target.white_brightness = percent / 100.0f;
+    NeewerLightTarget snapped;
+    NEEWER_CHECK_EQ(encode_twice(output, target, &snapped).data()[CCT_BRIGHTNESS], percent);
+  }
+}
+
+template<typename Output> static void check_colour(Output &output) {
+  static const float COLOURS[][3] = {
+      {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.5f, 0.25f}, {0.3f, 1.0f, 0.7f},
+      {0.9f, 0.1f, 1.0f}, {1.0f, 1.0f, 1.0f},
+  };
+  for (const auto &colour : COLOURS) {
+    for (int level = 1; level < 256; level++) {
+      NeewerLightTarget target;
+      target.on = true;
+      target.red = colour[0] * level / 255.0f;
+      target.green = colour[1] * level / 255.0f;
+      target.blue = colour[2] * level / 255.0f;
+      NeewerLightTarget snapped;
+      const NeewerPacket frame = encode_twice(output, target, &snapped);
+      const float snapped_max = std::max(snapped.red, std::max(snapped.green, snapped.blue));
+      NEEWER_CHECK_EQ(frame.tag(), HSI_TAG);
+      // A dim light stays lit: the lowest levels encode 1%, never 0.
+      NEEWER_CHECK_EQ(frame.data()[HSI_BRIGHTNESS], percent_byte(level / 255.0));
+      NEEWER_CHECK_EQ(frame.data()[HSI_BRIGHTNESS], lroundf(snapped_max * 100.0f));
+    }
+    for (int percent = 1; percent <= 100; percent++) {
+      NeewerLightTarget target;
+      target.on = true;
+      target.red = colour[0] * percent / 100.0f;
+      target.green = colour[1] * percent / 100.0f;
+      target.blue = colour[2] * percent / 100.0f;
+      NeewerLightTarget snapped;
+      NEEWER_CHECK_EQ(encode_twice(output, target, &snapped).data()[HSI_BRIGHTNESS], percent);
+    }
+  }
+}
+
+template<typename Output> static void check_color_temperature(Output &output) {
+  for (int step = 0; step <= 1000; step++) {
+    NeewerLightTarget target;
+    target.on = true;
+    target.white_brightness = 0.5f;
+    target.color_temperature = step / 1000.0f;
+    NeewerLightTarget snapped;
+    encode_twice(output, target, &snapped);
+  }
+}
+
+int main() {
+  NeewerModelLightOutput<NeewerRgb660Model> rgb660;
+  NeewerModelLightOutput<NeewerRgb62Model> rgb62;
+  check_white(rgb660);
+  check_white(rgb62);
+  check_colour(rgb660);
+  check_colour(rgb62);
+  check_color_temperature(rgb660);
+  check_color_temperature(rgb62);
+
+  // The legacy CCT byte resolves 1/24 of the range: every step lands on its own byte.
+  for (int step = 0; step <= 24; step++) {
+    NeewerLightTarget target;
+    target.on = true;
+    target.white_brightness = 0.5f;
+    target.color_temperature = step / 24.0f;
+    NeewerLightTarget snapped;
+    NEEWER_CHECK_EQ(encode_twice(rgb660, target, &snapped).data()[CCT_BYTE], 56 - step);
+  }
+  return neewer_test::finish("test_encode");
+}
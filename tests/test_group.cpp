@@ -0,0 +1,70 @@
+// neewerlight_group on simulated lights: what the group entity offers, and what
+// its fan-out leaves behind on each member.
+
+#include <cmath>
+
+#include "../components/neewerlight_group/neewer_group_light_output.h"
+#include "neewer_test.h"
+#include "sim/neewer_sim.h"
+#include "sim/neewer_sim_models.h"
+
+using namespace esphome;
+using namespace esphome::neewerlight;
+using namespace esphome::neewerlight_group;
+using namespace esphome::neewer_sim;
+
+static const uint64_t LIGHT_MAC = 0xF80C31D67480ULL;
+
+static void test_traits_cover_only_the_range_every_member_shows() {
+  NeewerModelLightOutput<NeewerRgb62Model> wide;      // 2500 - 8500 K
+  NeewerModelLightOutput<NeewerRgb660Model> narrow;  // 3200 - 5600 K
+  NeewerGroupLightOutput group;
+  group.add_member(&wide);
+  group.add_member(&narrow);
+
+  const auto traits = group.get_traits();
+  NEEWER_CHECK_EQ(static_cast<int>(roundf(1000000.0f / traits.get_min_mireds())), 5600);
+  NEEWER_CHECK_EQ(static_cast<int>(roundf(1000000.0f / traits.get_max_mireds())), 3200);
+}
+
+// A member that took the lead's frame never encoded it itself; a scene on it
+// afterwards still has to carry the colour the group sent.
+static void test_member_scene_after_a_shared_frame_takes_the_group_colour() {
+  SimWorld world;
+  NeewerModelLightOutput<NeewerRgb62Model> outputs[2];
+  light::LightState member_states[2] = {light::LightState{&outputs[0]}, light::LightState{&outputs[1]}};
+  SimLink *links[2];
+  NeewerGroupLightOutput group;
+  for (int i = 0; i < 2; i++) {
+    links[i] = &world.add_light(&outputs[i], LIGHT_MAC + i);
+    group.add_member(&outputs[i]);
+  }
+  light::LightState state{&group};
+  for (auto *link : links)
+    link->connect();
+  NEEWER_CHECK(world.run_until([&outputs] { return outputs[0].is_link_ready() && outputs[1].is_link_ready(); },
+                               2000));
+  world.run_for(500);
+
+  state.set_rgbct(true, 0.0f, 0.3f, 0.6f, 0.0f, 0.0f);
+  group.write_state(&state);
+  world.run_for(300);
+  const SimPanel colour = links[1]->light().panel();
+  NEEWER_CHECK(colour.mode == SimMode::HSI);
+  NEEWER_CHECK_EQ(colour.brightness, 60);
+
+  // Scene 9 (Hue Pulse) on an RGB62: brightness, hue LSB, hue MSB, saturation, speed.
+  NEEWER_CHECK(outputs[1].activate_scene(9));
+  world.run_for(300);
+  const SimPanel &scene = links[1]->light().panel();
+  NEEWER_CHECK_EQ(scene.scene, 9);
+  NEEWER_CHECK_EQ(scene.scene_params[0], colour.brightness);
+  NEEWER_CHECK_EQ(scene.scene_params[1] | (scene.scene_params[2] << 8), colour.hue);
+  NEEWER_CHECK_EQ(scene.scene_params[3], colour.saturation);
+}
+
+int main() {
+  test_traits_cover_only_the_range_every_member_shows();
+  test_member_scene_after_a_shared_frame_takes_the_group_colour();
+  return neewer_test::finish("test_group");
+}
@@ -0,0 +1,426 @@
+// End to end: NeewerRGBCTLightOutput::write_state through the fake GATT client
+// to a simulated light, including a lossy link and a light that stops answering.
+
+#include <cmath>
+
+#include "../components/neewerlight/neewer_keyframe_effect.h"
+#include "neewer_test.h"
+#include "sim/neewer_sim.h"
+#include "sim/neewer_sim_models.h"
+
+using namespace esphome;
+using namespace esphome::neewerlight;
+using namespace esphome::neewer_sim;
+
+static const uint64_t LIGHT_MAC = 0xF80C31D6748CULL;
+
+struct Fixture {
+  explicit Fixture(bool require_response = true, const SimLightConfig &config = SimLightConfig())
+      : link(world.add_light(&output, LIGHT_MAC, config)) {
+    this->output.set_require_response(require_response);
+  }
+
+  void set(bool on, float red, float green, float blue, float color_temperature, float white_brightness) {
+    this->state.set_rgbct(on, red, green, blue, color_temperature, white_brightness);
+    static_cast<light::LightOutput &>(this->output).write_state(&this->state);
+  }
+  bool connect() {
+    this->link.connect();
+    return this->world.run_until([this] { return this->output.is_link_ready(); }, 2000);
+  }
+  const SimPanel &panel() { return this->link.light().panel(); }
+  const SimCounters &counters() { return this->link.light().counters(); }
+
+  SimWorld world;
+  NeewerModelLightOutput<NeewerRgb660Model> output;
+  light::LightState state{&output};
+  SimLink &link;
+};
+
+// Runs first: the local MTU is set once per process, like once per boot on the device.
+static void test_local_mtu_is_set_once_before_connecting() {
+  SimWorld world;
+  NeewerModelLightOutput<NeewerRgb660Model> outputs[3];
+  SimLink *links[3];
+  for (int i = 0; i < 3; i++) {
+    outputs[i].set_mtu(64);
+    links[i] = &world.add_light(&outputs[i], LIGHT_MAC + i);
+  }
+  world.run_for(10);
+  NEEWER_CHECK_EQ(world.get_local_mtu_sets(), 1);
+  NEEWER_CHECK_EQ(world.get_local_mtu(), 64);
+
+  for (auto *link : links)
+    link->connect();
+  NEEWER_CHECK(world.run_until([&outputs] { return outputs[2].is_link_ready(); }, 2000));
+  NEEWER_CHECK_EQ(world.get_local_mtu_sets(), 1);
+  for (auto *link : links) {
+    // Only ble_client's own exchange, which the light answers with the local MTU.
+    NEEWER_CHECK_EQ(link->light().counters().mtu_requests, 1);
+    NEEWER_CHECK_EQ(link->granted_mtu(), 64);
+  }
+}
+
+static void test_connect_reads_status() {
+  Fixture f;
+  f.link.light().panel().on = true;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  NEEWER_CHECK(f.counters().cccd_writes >= 1);
+  NEEWER_CHECK(f.counters().power_status >= 1);
+  // The light's own power state was reported back to the light entity.
+  NEEWER_CHECK(f.state.get_reported_calls() >= 1);
+  NEEWER_CHECK(f.state.current_values.is_on());
+}
+
+static void test_color_white_and_off() {
+  Fixture f;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+
+  f.set(true, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK(f.panel().on);
+  NEEWER_CHECK(f.panel().mode == SimMode::HSI);
+  NEEWER_CHECK_EQ(f.panel().hue, 240);
+  NEEWER_CHECK_EQ(f.panel().saturation, 100);
+  NEEWER_CHECK_EQ(f.panel().brightness, 50);
+
+  f.set(true, 0.0f, 0.0f, 0.0f, 0.5f, 0.6f);
+  f.world.run_for(300);
+  NEEWER_CHECK(f.panel().mode == SimMode::CCT);
+  NEEWER_CHECK_EQ(f.panel().brightness, 60);
+  NEEWER_CHECK_EQ(f.panel().cct, 44);  // legacy layout: |0.5 * 24 - 56|
+
+  // One status check once the light has been quiet for status_verify_delay.
+  const uint32_t status_before = f.counters().power_status;
+  f.world.run_for(1500);
+  NEEWER_CHECK_EQ(f.counters().power_status, status_before + 1);
+
+  f.set(false, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK(!f.panel().on);
+  NEEWER_CHECK_EQ(f.counters().invalid, 0);
+}
+
+static void test_identical_frames_are_suppressed() {
+  Fixture f;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+
+  f.set(true, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  const uint32_t hsi = f.counters().hsi;
+  // The light acknowledged this frame, so sending it again is dropped.
+  f.set(true, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.counters().hsi, hsi);
+  NEEWER_CHECK_EQ(f.output.get_suppressed_writes(), 1);
+
+  // Back to the acknowledged frame while another one is in flight: it has to go out.
+  f.set(true, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.set(true, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.panel().hue, 240);
+  NEEWER_CHECK_EQ(f.counters().hsi, hsi + 2);
+  NEEWER_CHECK_EQ(f.output.get_suppressed_writes(), 1);
+}
+
+static void test_ack_latency_is_measured() {
+  SimLightConfig config;
+  config.ack_latency_ms = 80;
+  Fixture f(true, config);
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(1000);
+
+  const uint32_t frames_before = f.output.get_stats().user_frames;
+  const uint64_t total_before = f.output.get_stats().user_latency_us_total;
+  f.set(true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(500);
+  const auto &stats = f.output.get_stats();
+  // Power on, then the colour frame behind it.
+  NEEWER_CHECK_EQ(stats.user_frames - frames_before, 2);
+  const uint64_t average_us = (stats.user_latency_us_total - total_before) / (stats.user_frames - frames_before);
+  NEEWER_CHECK(average_us >= 80000 && average_us < 200000);
+}
+
+static void test_lossy_link_falls_back_to_acknowledged_writes() {
+  Fixture f(false);
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  f.set(true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK(f.counters().writes_no_rsp >= 1);
+
+  // Everything is lost for a while: the status checks after each change time out.
+  f.link.set_loss(1.0f);
+  for (int i = 0; i < 4; i++) {
+    f.set(true, 0.0f, 1.0f - 0.2f * i, 0.0f, 0.0f, 0.0f);
+    f.world.run_for(2500);
+  }
+  NEEWER_CHECK(f.output.get_stats().write_failures + f.output.get_stats().status_timeouts >= 3);
+
+  f.link.set_loss(0.0f);
+  f.world.run_for(3000);
+  const uint32_t no_rsp_before = f.counters().writes_no_rsp;
+  const uint32_t rsp_before = f.counters().writes_rsp;
+  f.set(true, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  // The colour frame now goes out acknowledged and lands.
+  NEEWER_CHECK_EQ(f.counters().writes_no_rsp, no_rsp_before);
+  NEEWER_CHECK(f.counters().writes_rsp > rsp_before);
+  NEEWER_CHECK_EQ(f.panel().hue, 240);
+}
+
+// Sends a target straight to the output, past the frame rate limit of write_state.
+static uint32_t apply(Fixture &f, bool on, float red, float green, float blue) {
+  NeewerLightTarget target;
+  target.on = on;
+  target.red = red;
+  target.green = green;
+  target.blue = blue;
+  const NeewerCommandClass frame_class = f.output.encode_target(&target);
+  return f.output.apply_target(target, f.output.get_encoded_frame(), frame_class);
+}
+
+struct KeyframeProbe : NeewerKeyframeLightEffect {
+  KeyframeProbe() : NeewerKeyframeLightEffect("Probe", 64) {}
+  size_t table_capacity() const { return this->frames_.capacity(); }
+};
+
+static void test_keyframe_table_is_held_only_while_the_effect_runs() {
+  Fixture f;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  KeyframeProbe effect;
+  effect.add_keyframe(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1000, NeewerEasing::LINEAR);
+  effect.add_keyframe(0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1000, NeewerEasing::LINEAR);
+  NEEWER_CHECK_EQ(effect.table_capacity(), 0);
+
+  f.state.start_effect(&effect);
+  // 2 s at 10 frames per second, not the 64 frames it may grow to.
+  NEEWER_CHECK_EQ(effect.table_capacity(), 20);
+  for (int i = 0; i < 10; i++) {
+    effect.apply();
+    f.world.run_for(100);
+  }
+  NEEWER_CHECK(f.counters().hsi >= 5);
+
+  f.state.stop_effect();
+  NEEWER_CHECK_EQ(effect.table_capacity(), 0);
+}
+
+// Scene 9 (Hue Pulse) on an RGB62: brightness, hue LSB, hue MSB, saturation, speed.
+static void check_hue_pulse_matches_panel(NeewerModelLightOutput<NeewerRgb62Model> &output, SimLink &link,
+                                          SimWorld &world) {
+  const SimPanel colour = link.light().panel();
+  NEEWER_CHECK(colour.mode == SimMode::HSI);
+  NEEWER_CHECK(output.activate_scene(9));
+  world.run_for(300);
+  const SimPanel &scene = link.light().panel();
+  NEEWER_CHECK_EQ(scene.scene, 9);
+  NEEWER_CHECK_EQ(scene.scene_params[0], colour.brightness);
+  NEEWER_CHECK_EQ(scene.scene_params[1] | (scene.scene_params[2] << 8), colour.hue);
+  NEEWER_CHECK_EQ(scene.scene_params[3], colour.saturation);
+}
+
+static void test_scene_after_an_effect_takes_the_colour_last_sent() {
+  SimWorld world;
+  NeewerModelLightOutput<NeewerRgb62Model> output;
+  light::LightState state{&output};
+  SimLink &link = world.add_light(&output, LIGHT_MAC);
+  link.connect();
+  NEEWER_CHECK(world.run_until([&output] { return output.is_link_ready(); }, 2000));
+  world.run_for(500);
+
+  // Red to blue at 40% over 2 s, stopped halfway: compiling the table must not
+  // leave its last sample (blue) behind as the light's colour.
+  NeewerKeyframeLightEffect effect("Fade", 64);
+  effect.set_loop(false);
+  effect.add_keyframe(0.4f, 0.0f, 0.0f, 0.0f, 0.0f, 2000, NeewerEasing::LINEAR);
+  effect.add_keyframe(0.0f, 0.0f, 0.4f, 0.0f, 0.0f, 0, NeewerEasing::LINEAR);
+  const uint32_t encodes = output.get_stats().encodes;
+  state.start_effect(&effect);
+  NEEWER_CHECK_EQ(output.get_stats().encodes, encodes);
+  for (int i = 0; i < 10; i++) {
+    effect.apply();
+    world.run_for(100);
+  }
+  state.stop_effect();
+  world.run_for(300);
+  NEEWER_CHECK(link.light().panel().hue != 240);
+  check_hue_pulse_matches_panel(output, link, world);
+}
+
+static void test_channel_change_on_the_light_forgets_acknowledged_state() {
+  Fixture f;
+  f.output.set_track_channel(true);
+  f.output.set_status_poll_interval(500);
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  f.set(true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(1500);
+  NEEWER_CHECK_EQ(f.output.get_stats().channel, 1);
+
+  // Someone sets another channel and a different colour on the light's buttons.
+  f.link.light().panel().channel = 3;
+  f.link.light().panel().hue = 120;
+  f.world.run_for(1000);
+  NEEWER_CHECK_EQ(f.output.get_stats().channel, 3);
+  NEEWER_CHECK_EQ(f.output.get_stats().channel_changes, 1);
+
+  // The same colour again is no longer taken as already shown.
+  f.set(true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.panel().hue, 0);
+  NEEWER_CHECK_EQ(f.output.get_suppressed_writes(), 0);
+}
+
+static void test_confirm_latency_excludes_the_verify_delay() {
+  Fixture f;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  const NeewerLatencyHistogram before = f.output.get_latency(NeewerLatencyStage::CONFIRM);
+  f.set(true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(1500);
+  // Confirmed by the one query sent after status_verify_delay (1 s), but timed
+  // from that query going out, not from the light call.
+  const float confirm_ms = f.output.get_latency(NeewerLatencyStage::CONFIRM).percentile_since(before, 0.5f);
+  NEEWER_CHECK(!std::isnan(confirm_ms));
+  NEEWER_CHECK(confirm_ms < 200.0f);
+}
+
+static void test_late_completion_is_not_credited_to_the_next_write() {
+  Fixture f(false);
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  apply(f, true, 1.0f, 0.0f, 0.0f);
+  f.world.run_for(300);
+
+  // The colour frame's completion comes 40 ms after it was sent, when the power
+  // frame behind it has already gone out and waits 80 ms for its own.
+  f.link.set_no_rsp_latency(40);
+  f.link.set_ack_latency(80);
+  apply(f, true, 0.0f, 1.0f, 0.0f);
+  f.world.run_for(20);
+  const uint32_t power = apply(f, false, 0.0f, 0.0f, 0.0f);
+  NEEWER_CHECK(power != 0);
+  f.world.run_for(40);
+  NEEWER_CHECK(!f.output.is_acknowledged(power));
+  f.world.run_for(100);
+  NEEWER_CHECK(f.output.is_acknowledged(power));
+  NEEWER_CHECK_EQ(f.output.get_stats().write_failures, 0);
+}
+
+static void test_rising_write_latency_falls_back_to_acknowledged_writes() {
+  Fixture f(false);
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  for (int i = 0; i < 10; i++) {
+    apply(f, true, 1.0f, 0.01f * (i + 1), 0.0f);
+    f.world.run_for(50);
+  }
+  // Nothing is lost, but writes take ever longer to leave the controller.
+  f.link.set_no_rsp_latency(150);
+  for (int i = 0; i < 10; i++) {
+    apply(f, true, 0.0f, 1.0f, 0.01f * (i + 1));
+    f.world.run_for(50);
+  }
+  f.world.run_for(500);
+  NEEWER_CHECK_EQ(f.counters().lost, 0);
+
+  const uint32_t no_rsp_before = f.counters().writes_no_rsp;
+  const uint32_t rsp_before = f.counters().writes_rsp;
+  apply(f, true, 0.0f, 0.0f, 1.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.counters().writes_no_rsp, no_rsp_before);
+  NEEWER_CHECK(f.counters().writes_rsp > rsp_before);
+  NEEWER_CHECK_EQ(f.panel().hue, 240);
+}
+
+static void test_unresponsive_light_recovers() {
+  Fixture f;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  f.set(true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.panel().hue, 0);
+
+  f.link.set_unresponsive(true);
+  f.set(true, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(6000);
+  NEEWER_CHECK(f.counters().ignored >= 1);
+  NEEWER_CHECK(f.output.get_stats().write_failures >= 1);
+  NEEWER_CHECK(f.output.get_stats().status_timeouts >= 1);
+  NEEWER_CHECK_EQ(f.panel().hue, 0);
+  // Nothing is stuck in flight once the timeouts have run.
+  NEEWER_CHECK(f.output.link_idle());
+
+  f.link.set_unresponsive(false);
+  f.set(true, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.panel().hue, 240);
+}
+
+static void test_nothing_is_written_before_cached_handles_are_proven() {
+  Fixture f;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  apply(f, true, 1.0f, 0.0f, 0.0f);
+  f.world.run_for(300);
+  f.link.disconnect();
+  f.world.run_for(10);
+
+  // A command right after the link opens waits for the CCCD write on the cached
+  // handles to be acknowledged instead of going out on them unchecked.
+  f.link.connect();
+  NEEWER_CHECK(f.world.run_until([&f] { return f.output.is_connected(); }, 100));
+  const uint32_t writes = f.counters().writes;
+  apply(f, true, 0.0f, 1.0f, 0.0f);
+  f.world.run_for(10);
+  NEEWER_CHECK(!f.output.is_link_ready());
+  NEEWER_CHECK_EQ(f.counters().writes, writes);
+  NEEWER_CHECK(f.world.run_until([&f] { return f.output.is_link_ready(); }, 300));
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.panel().hue, 120);
+}
+
+static void test_reconnect_resyncs_on_cached_handles() {
+  Fixture f;
+  NEEWER_CHECK(f.connect());
+  f.world.run_for(500);
+  f.set(true, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  f.world.run_for(1500);
+
+  f.link.disconnect();
+  f.world.run_for(10);
+  f.set(true, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+  NEEWER_CHECK_EQ(f.panel().hue, 0);
+
+  f.link.connect();
+  // Ready on the cached handles well before discovery would have completed.
+  NEEWER_CHECK(f.world.run_until([&f] { return f.output.is_link_ready(); }, 300));
+  NEEWER_CHECK_EQ(f.output.get_stats().handle_cache_hits, 1);
+  f.world.run_for(300);
+  NEEWER_CHECK_EQ(f.panel().hue, 120);
+  NEEWER_CHECK_EQ(f.output.get_stats().resyncs, 2);
+}
+
+int main() {
+  test_local_mtu_is_set_once_before_connecting();
+  test_connect_reads_status();
+  test_color_white_and_off();
+  test_identical_frames_are_suppressed();
+  test_ack_latency_is_measured();
+  test_lossy_link_falls_back_to_acknowledged_writes();
+  test_keyframe_table_is_held_only_while_the_effect_runs();
+  test_scene_after_an_effect_takes_the_colour_last_sent();
+  test_channel_change_on_the_light_forgets_acknowledged_state();
+  test_confirm_latency_excludes_the_verify_delay();
+  test_late_completion_is_not_credited_to_the_next_write();
+  test_rising_write_latency_falls_back_to_acknowledged_writes();
+  test_unresponsive_light_recovers();
+  test_reconnect_resyncs_on_cached_handles();
+  test_nothing_is_written_before_cached_handles_are_proven();
+  return neewer_test::finish("test_light_output");
+}
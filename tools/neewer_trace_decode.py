@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""Decode a neewerlight packet trace dump into a readable timeline.
+
+Trigger the dump with the `neewerlight.dump_packet_trace` action, then feed the
+device log (or just the `[nwtrace]` lines) to this script:
+
+    esphome logs studio.yaml | tee studio.log
+    python3 tools/neewer_trace_decode.py studio.log
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+TRACE_RE = re.compile(r"\[nwtrace\] (.*)$")
+HEADER = struct.Struct("<IBBB")
+FRAME_SIZE = 20
+
+KINDS = {0: "TX", 1: "ACK", 2: "RX"}
+TX_TAGS = {
+    0x81: "power",
+    0x84: "channel status?",
+    0x85: "power status?",
+    0x86: "HSI",
+    0x87: "CCT",
+    0x8B: "FX",
+    0x8D: "Infinity power",
+    0x8F: "Infinity HSI",
+    0x90: "Infinity CCT",
+    0x91: "Infinity FX",
+}
+# Infinity frames carry the light's MAC and a subtag before the payload.
+INFINITY_POWER_TAG = 0x8D
+INFINITY_PAYLOAD_OFFSET = 3 + 6 + 1
+RX_TAGS = {0x01: "channel status", 0x02: "power status"}
+
+
+def describe(kind, data):
+    if kind == "ACK":
+        return "ok" if data and data[0] == 0 else f"status={data[0] if data else '?'}"
+    if len(data) < 2:
+        return ""
+    tags = TX_TAGS if kind == "TX" else RX_TAGS
+    name = tags.get(data[1], f"tag 0x{data[1]:02X}")
+    if kind == "TX" and data[1] == 0x81 and len(data) > 3:
+        name += " on" if data[3] == 0x01 else " off"
+    if kind == "TX" and data[1] == INFINITY_POWER_TAG and len(data) > INFINITY_PAYLOAD_OFFSET:
+        name += " on" if data[INFINITY_PAYLOAD_OFFSET] == 0x01 else " off"
+    if kind == "RX" and len(data) > 3:
+        name += f" = 0x{data[3]:02X}"
+    return name
+
+
+def parse(lines):
+    lights = {}
+    entries = []
+    for line in lines:
+        match = TRACE_RE.search(line.rstrip())
+        if match is None:
+            continue
+        body = match.group(1).strip()
+        if body.startswith("light "):
+            _, light_id, address = body.split(maxsplit=2)
+            lights[int(light_id)] = address
+            continue
+        if body.startswith(("begin", "end")):
+            if body.startswith("begin"):
+                entries.clear()
+            continue
+        raw = bytes.fromhex(body)
+        timestamp_us, light_id, kind, length = HEADER.unpack_from(raw)
+        data = raw[HEADER.size : HEADER.size + min(length, FRAME_SIZE)]
+        entries.append((timestamp_us, light_id, KINDS.get(kind, str(kind)), length, data))
+    return lights, entries
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"), default=sys.stdin)
+    args = parser.parse_args()
+
+    lights, entries = parse(args.log)
+    if not entries:
+        print("no [nwtrace] entries found", file=sys.stderr)
+        return 1
+
+    start = entries[0][0]
+    previous = start
+    last_tx = {}
+    latencies = {}
+    for timestamp_us, light_id, kind, length, data in entries:
+        # micros() wraps every ~71 minutes; the ring never spans that long.
+        offset = (timestamp_us - start) & 0xFFFFFFFF
+        delta = (timestamp_us - previous) & 0xFFFFFFFF
+        previous = timestamp_us
+        note = describe(kind, data)
+        if kind == "TX":
+            last_tx[light_id] = timestamp_us
+        elif kind == "ACK" and light_id in last_tx:
+            latency = (timestamp_us - last_tx.pop(light_id)) & 0xFFFFFFFF
+            latencies.setdefault(light_id, []).append(latency)
+            note += f" after {latency / 1000:.1f} ms"
+        truncated = "…" if length > len(data) else ""
+        print(
+            f"{offset / 1000:10.3f} ms  +{delta / 1000:8.3f}  "
+            f"{lights.get(light_id, f'light {light_id}'):>17}  {kind:<3}  "
+            f"{data.hex(' '):<60}{truncated}  {note}"
+        )
+
+    if latencies:
+        print()
+        print("write ack latency (ms):")
+        for light_id, values in sorted(latencies.items()):
+            name = lights.get(light_id, f"light {light_id}")
+            print(
+                f"  {name:>17}  n={len(values):<4} min={min(values) / 1000:.1f} "
+                f"avg={sum(values) / len(values) / 1000:.1f} max={max(values) / 1000:.1f}"
+            )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Send E1.31 (sACN) DMX data to a neewerlight_sacn node.
+
+Stands in for a lighting console when testing: it streams one universe at a
+console-like rate with a single light footprint (intensity, CCT, hue,
+saturation, FX) at the given start address. `--sweep` rotates the hue so
+every packet carries new data; watch the `[nwsacn]` stats line on the device
+for frames sent, superseded and input-to-wire latency.
+
+    python3 tools/sacn_send.py 192.168.1.50 --universe 1 --intensity 255 --saturation 255 --sweep
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+import uuid
+
+PORT = 5568
+ACN_PACKET_IDENTIFIER = b"ASC-E1.17\x00\x00\x00"
+VECTOR_ROOT_E131_DATA = 0x00000004
+VECTOR_E131_DATA_PACKET = 0x00000002
+VECTOR_DMP_SET_PROPERTY = 0x02
+SLOTS = 512
+
+
+def flags_length(length):
+    return 0x7000 | length
+
+
+def build_packet(cid, source, universe, sequence, priority, dmx):
+    dmp = struct.pack(
+        "!HBBHHHB", flags_length(10 + 1 + len(dmx)), VECTOR_DMP_SET_PROPERTY, 0xA1, 0, 1, 1 + len(dmx), 0
+    ) + bytes(dmx)
+    framing = (
+        struct.pack("!HI", flags_length(77 + len(dmp)), VECTOR_E131_DATA_PACKET)
+        + source.encode()[:63].ljust(64, b"\x00")
+        + struct.pack("!BHBBH", priority, 0, sequence, 0, universe)
+        + dmp
+    )
+    root = (
+        struct.pack("!HH", 0x0010, 0x0000)
+        + ACN_PACKET_IDENTIFIER
+        + struct.pack("!HI", flags_length(22 + len(framing)), VECTOR_ROOT_E131_DATA)
+        + cid
+        + framing
+    )
+    return root
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", help="device address (unicast)")
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--universe", type=int, default=1)
+    parser.add_argument("--address", type=int, default=1, help="start address of the footprint")
+    parser.add_argument("--intensity", type=int, default=255)
+    parser.add_argument("--cct", type=int, default=128)
+    parser.add_argument("--hue", type=int, default=0)
+    parser.add_argument("--saturation", type=int, default=0)
+    parser.add_argument("--fx", type=int, default=0)
+    parser.add_argument("--rate", type=float, default=44.0, help="packets per second")
+    parser.add_argument("--sweep", action="store_true", help="rotate the hue one step per packet")
+    parser.add_argument("--seconds", type=float, default=0.0, help="stop after this long (0 = until ^C)")
+    args = parser.parse_args()
+
+    if not 1 <= args.address <= SLOTS - 4:
+        parser.error("--address must leave room for the 5-slot footprint")
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    cid = uuid.uuid4().bytes
+    dmx = bytearray(SLOTS)
+    footprint = [args.intensity, args.cct, args.hue, args.saturation, args.fx]
+    interval = 1.0 / args.rate
+    sequence = 0
+    sent = 0
+    start = time.monotonic()
+    next_send = start
+    try:
+        while args.seconds <= 0 or time.monotonic() - start < args.seconds:
+            if args.sweep:
+                footprint[2] = (footprint[2] + 1) % 256
+            dmx[args.address - 1 : args.address + 4] = bytes(v & 0xFF for v in footprint)
+            sock.sendto(build_packet(cid, "neewer sacn_send", args.universe, sequence, 100, dmx), (args.host, args.port))
+            sequence = (sequence + 1) % 256
+            sent += 1
+            next_send += interval
+            time.sleep(max(0.0, next_send - time.monotonic()))
+    except KeyboardInterrupt:
+        pass
+    elapsed = time.monotonic() - start
+    print(f"sent {sent} packets in {elapsed:.1f}s ({sent / elapsed:.1f}/s)", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())